@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <glib.h>
+
+#include "Helpers/EventSource2.h"
+
+#include "Qt/QActor.h"
+
+
+namespace {
+
+enum {
+    DEFAULT_PRODUCERS = 4,
+    DEFAULT_ACTIONS = 1000000, // per producer
+    DEFAULT_LATENCY_SAMPLES = 10000,
+};
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options
+{
+    gint producers = DEFAULT_PRODUCERS;
+    gint actions = DEFAULT_ACTIONS;
+    gint samples = DEFAULT_LATENCY_SAMPLES;
+};
+
+// QActor as it was before lock-free queue: std::function allocated on heap,
+// pushed through mutex based GAsyncQueue with wakeup on every post
+class LegacyActor
+{
+public:
+    typedef std::function<void ()> Action;
+
+    LegacyActor();
+    ~LegacyActor();
+
+    void postAction(Action&&);
+
+private:
+    struct QueuedAction {
+        Action action;
+    };
+
+    static void OnEvent(GAsyncQueue*);
+
+    GMainContext* _mainContext;
+    GMainLoop* _mainLoop;
+    GAsyncQueue* _queue;
+    EventSource2 _notifier;
+    std::thread _thread;
+};
+
+LegacyActor::LegacyActor() :
+    _mainContext(g_main_context_new()),
+    _mainLoop(g_main_loop_new(_mainContext, FALSE)),
+    _queue(g_async_queue_new()),
+    _notifier(_mainContext)
+{
+    std::promise<void> started;
+    _thread = std::thread([this, &started] () {
+        g_main_context_push_thread_default(_mainContext);
+        _notifier.subscribe(std::bind(&OnEvent, _queue));
+        started.set_value();
+        g_main_loop_run(_mainLoop);
+        g_main_context_pop_thread_default(_mainContext);
+    });
+    started.get_future().wait();
+}
+
+LegacyActor::~LegacyActor()
+{
+    postAction([loop = _mainLoop] () { g_main_loop_quit(loop); });
+    _thread.join();
+
+    g_async_queue_unref(_queue);
+    g_main_loop_unref(_mainLoop);
+    g_main_context_unref(_mainContext);
+}
+
+void LegacyActor::OnEvent(GAsyncQueue* queue)
+{
+    while(gpointer item = g_async_queue_try_pop(queue)) {
+        std::unique_ptr<QueuedAction>(static_cast<QueuedAction*>(item))->action();
+    }
+}
+
+void LegacyActor::postAction(Action&& action)
+{
+    g_async_queue_push(_queue, new QueuedAction { std::move(action) });
+    _notifier.postEvent();
+}
+
+template<typename Actor>
+double Throughput(Actor* actor, unsigned producers, unsigned actions)
+{
+    const unsigned total = producers * actions;
+    unsigned executed = 0; // touched from actor thread only
+    std::promise<void> done;
+
+    const Clock::time_point start = Clock::now();
+
+    std::vector<std::thread> threads;
+    for(unsigned p = 0; p < producers; ++p) {
+        threads.emplace_back([actor, actions, total, &executed, &done] () {
+            for(unsigned i = 0; i < actions; ++i) {
+                actor->postAction([total, &executed, &done] () {
+                    if(++executed == total)
+                        done.set_value();
+                });
+            }
+        });
+    }
+
+    for(std::thread& thread: threads)
+        thread.join();
+    done.get_future().wait();
+
+    const std::chrono::duration<double> duration = Clock::now() - start;
+
+    return total / duration.count();
+}
+
+// every action is posted only after previous one executed,
+// so it's wakeup latency of idle actor
+template<typename Actor>
+std::vector<double> Latency(Actor* actor, unsigned samples)
+{
+    std::vector<double> latencies; // us
+    latencies.reserve(samples);
+
+    std::atomic<bool> executed;
+    for(unsigned i = 0; i < samples; ++i) {
+        executed.store(false, std::memory_order_relaxed);
+
+        actor->postAction([postedAt = Clock::now(), &latencies, &executed] () {
+            latencies.push_back(
+                std::chrono::duration<double, std::micro>(Clock::now() - postedAt).count());
+            executed.store(true, std::memory_order_release);
+        });
+
+        while(!executed.load(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    return latencies;
+}
+
+template<typename Actor>
+void Run(const char* name, const Options& options)
+{
+    Actor actor;
+
+    const double actionsPerSecond = Throughput(&actor, options.producers, options.actions);
+    const std::vector<double> latencies = Latency(&actor, options.samples);
+
+    printf(
+        "%-8s actions/s: %12.0f, latency us p50: %8.2f, p99: %8.2f, max: %8.2f\n",
+        name,
+        actionsPerSecond,
+        latencies[latencies.size() / 2],
+        latencies[latencies.size() * 99 / 100],
+        latencies.back());
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    GOptionEntry entries[] = {
+        { "producers", 'p', 0, G_OPTION_ARG_INT, &options.producers, "Threads posting actions concurrently", "N" },
+        { "actions", 'a', 0, G_OPTION_ARG_INT, &options.actions, "Actions posted by every producer", "N" },
+        { "samples", 's', 0, G_OPTION_ARG_INT, &options.samples, "Post-to-execute latency samples", "N" },
+        { nullptr }
+    };
+
+    g_autoptr(GOptionContext) optionContext =
+        g_option_context_new("- QActor benchmark");
+    g_option_context_add_main_entries(optionContext, entries, nullptr);
+    g_autoptr(GError) error = nullptr;
+    if(!g_option_context_parse(optionContext, &argc, &argv, &error)) {
+        fprintf(stderr, "Failed to parse options: %s\n", error->message);
+        return -1;
+    }
+
+    if(options.producers <= 0 || options.actions <= 0 || options.samples <= 0) {
+        fprintf(stderr, "Invalid options\n");
+        return -1;
+    }
+
+    printf(
+        "%d producer(s), %d actions per producer, %d latency samples\n",
+        options.producers,
+        options.actions,
+        options.samples);
+
+    Run<LegacyActor>("legacy", options);
+    Run<QActor>("QActor", options);
+
+    return 0;
+}
@@ -0,0 +1,365 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <microhttpd.h>
+
+#include <spdlog/spdlog.h>
+
+#include <CxxPtr/CPtr.h>
+#include <CxxPtr/GlibPtr.h>
+
+#include "Http/Log.h"
+#include "Http/HttpMicroServer.h"
+
+
+namespace {
+
+enum {
+    DEFAULT_PORT = 5180,
+    DEFAULT_CLIENTS = 32,
+    DEFAULT_DURATION = 3, // seconds
+    DEFAULT_API_DELAY = 0, // ms
+    DEFAULT_PAGE_SIZE = 16 * 1024, // bytes
+};
+
+const char *const DefaultThreads = "1,2,4,8";
+const char *const ApiPrefix = "/api";
+const char *const ApiPath = "/api/bench";
+const char *const PagePath = "/index.html";
+const std::string ApiResponse = "{}";
+
+struct Options
+{
+    gint port = DEFAULT_PORT;
+    gint clients = DEFAULT_CLIENTS;
+    gint duration = DEFAULT_DURATION;
+    gint apiDelay = DEFAULT_API_DELAY;
+    gboolean api = FALSE;
+    gboolean async = FALSE;
+    gchar* threads = nullptr;
+};
+
+std::vector<unsigned> ParseThreads(const char* threads)
+{
+    std::vector<unsigned> out;
+
+    gchar** tokens = g_strsplit(threads, ",", -1);
+    for(gchar** token = tokens; *token; ++token) {
+        const gint64 value = g_ascii_strtoll(*token, nullptr, 10);
+        if(value <= 0) {
+            out.clear();
+            break;
+        }
+        out.push_back(static_cast<unsigned>(value));
+    }
+    g_strfreev(tokens);
+
+    return out;
+}
+
+// minimal keep-alive HTTP/1.1 client, returns false on any error
+class Connection
+{
+public:
+    bool connect(unsigned short port) noexcept;
+    bool get(const char* path) noexcept;
+
+private:
+    bool readResponse() noexcept;
+
+    int _fd = -1;
+    std::unique_ptr<FDAutoClose> _fdAutoClose;
+    std::string _buffer;
+};
+
+bool Connection::connect(unsigned short port) noexcept
+{
+    _fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(_fd == -1)
+        return false;
+
+    _fdAutoClose = std::make_unique<FDAutoClose>(_fd);
+
+    const int noDelay = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    return ::connect(_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+}
+
+bool Connection::get(const char* path) noexcept
+{
+    const std::string request =
+        std::string("GET ") + path + " HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "Accept-Encoding: gzip, br\r\n"
+        "\r\n";
+
+    size_t sent = 0;
+    while(sent < request.size()) {
+        const ssize_t size = send(_fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if(size <= 0)
+            return false;
+        sent += size;
+    }
+
+    return readResponse();
+}
+
+bool Connection::readResponse() noexcept
+{
+    char chunk[16 * 1024];
+
+    size_t headersEnd;
+    while((headersEnd = _buffer.find("\r\n\r\n")) == std::string::npos) {
+        const ssize_t size = recv(_fd, chunk, sizeof(chunk), 0);
+        if(size <= 0)
+            return false;
+        _buffer.append(chunk, size);
+    }
+
+    if(_buffer.compare(0, 12, "HTTP/1.1 200") != 0 && _buffer.compare(0, 12, "HTTP/1.1 304") != 0)
+        return false;
+
+    size_t contentLength = 0;
+    GCharPtr headersPtr(g_ascii_strdown(_buffer.data(), headersEnd));
+    if(const char* header = strstr(headersPtr.get(), "\r\ncontent-length:"))
+        contentLength = g_ascii_strtoull(header + strlen("\r\ncontent-length:"), nullptr, 10);
+
+    const size_t responseSize = headersEnd + 4 + contentLength;
+    while(_buffer.size() < responseSize) {
+        const ssize_t size = recv(_fd, chunk, sizeof(chunk), 0);
+        if(size <= 0)
+            return false;
+        _buffer.append(chunk, size);
+    }
+
+    _buffer.erase(0, responseSize);
+
+    return true;
+}
+
+struct RunResult
+{
+    unsigned long requests = 0;
+    unsigned long errors = 0;
+};
+
+RunResult Run(const Options& options, const char* path)
+{
+    std::atomic<unsigned long> requests = 0;
+    std::atomic<unsigned long> errors = 0;
+
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(options.duration);
+
+    std::vector<std::thread> clients;
+    for(int i = 0; i < options.clients; ++i) {
+        clients.emplace_back([&] () {
+            unsigned long clientRequests = 0;
+            unsigned long clientErrors = 0;
+
+            std::unique_ptr<Connection> connection;
+            while(std::chrono::steady_clock::now() < deadline) {
+                if(!connection) {
+                    connection = std::make_unique<Connection>();
+                    if(!connection->connect(options.port)) {
+                        ++clientErrors;
+                        connection.reset();
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                        continue;
+                    }
+                }
+
+                if(connection->get(path)) {
+                    ++clientRequests;
+                } else {
+                    ++clientErrors;
+                    connection.reset();
+                }
+            }
+
+            requests += clientRequests;
+            errors += clientErrors;
+        });
+    }
+
+    for(std::thread& client: clients)
+        client.join();
+
+    return RunResult { requests, errors };
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    GOptionEntry entries[] = {
+        { "port", 'p', 0, G_OPTION_ARG_INT, &options.port, "HTTP server port", "PORT" },
+        { "threads", 't', 0, G_OPTION_ARG_STRING, &options.threads, "Comma separated server thread pool sizes to test", "N,N,..." },
+        { "clients", 'c', 0, G_OPTION_ARG_INT, &options.clients, "Concurrent keep-alive client connections", "N" },
+        { "duration", 'd', 0, G_OPTION_ARG_INT, &options.duration, "Duration of every run", "SECONDS" },
+        { "api", 'a', 0, G_OPTION_ARG_NONE, &options.api, "Benchmark API handler instead of static page", nullptr },
+        { "api-delay", 0, 0, G_OPTION_ARG_INT, &options.apiDelay, "Simulated API handler processing time", "MS" },
+        { "async", 0, 0, G_OPTION_ARG_NONE, &options.async, "Use async API handler running on GLib main loop", nullptr },
+        { nullptr }
+    };
+
+    g_autoptr(GOptionContext) optionContext =
+        g_option_context_new("- WebRTSP HTTP server benchmark");
+    g_option_context_add_main_entries(optionContext, entries, nullptr);
+    g_autoptr(GError) error = nullptr;
+    if(!g_option_context_parse(optionContext, &argc, &argv, &error)) {
+        spdlog::critical("Failed to parse options: {}", error->message);
+        return -1;
+    }
+
+    GCharPtr threadsPtr(options.threads);
+    const std::vector<unsigned> threads = ParseThreads(options.threads ? options.threads : DefaultThreads);
+
+    if(options.port <= 0 || options.clients <= 0 || options.duration <= 0 ||
+        options.apiDelay < 0 || threads.empty())
+    {
+        spdlog::critical("Invalid options");
+        return -1;
+    }
+
+    InitHttpServerLogger(spdlog::level::warn);
+
+    GCharPtr wwwRootPtr(g_dir_make_tmp("HttpBench-XXXXXX", nullptr));
+    if(!wwwRootPtr) {
+        spdlog::critical("Failed to create temporary www dir");
+        return -1;
+    }
+
+    GCharPtr pageFilePtr(g_build_filename(wwwRootPtr.get(), PagePath, nullptr));
+    std::ofstream(pageFilePtr.get()) << std::string(DEFAULT_PAGE_SIZE, 'x');
+
+    GMainContextPtr contextPtr(g_main_context_new());
+
+    const std::chrono::milliseconds apiDelay(options.apiDelay);
+    auto apiHandler =
+        [apiDelay] (http::Method, const char*, const std::string_view&) -> std::pair<unsigned, MHD_Response*> {
+            if(apiDelay.count() > 0)
+                std::this_thread::sleep_for(apiDelay);
+
+            return {
+                MHD_HTTP_OK,
+                MHD_create_response_from_buffer(
+                    ApiResponse.size(),
+                    (void*)ApiResponse.c_str(),
+                    MHD_RESPMEM_PERSISTENT) };
+        };
+
+    auto asyncApiHandler =
+        [contextPtr = contextPtr.get(), apiDelay] (
+            http::Method,
+            const std::string&,
+            const std::string&,
+            const http::MicroServer::APIResponder& responder)
+        {
+            auto* responderCopy = new http::MicroServer::APIResponder(responder);
+            GSourcePtr timeoutSourcePtr(g_timeout_source_new(apiDelay.count()));
+            g_source_set_callback(
+                timeoutSourcePtr.get(),
+                [] (gpointer userData) -> gboolean {
+                    const auto* responder = reinterpret_cast<http::MicroServer::APIResponder*>(userData);
+                    (*responder)(
+                        MHD_HTTP_OK,
+                        MHD_create_response_from_buffer(
+                            ApiResponse.size(),
+                            (void*)ApiResponse.c_str(),
+                            MHD_RESPMEM_PERSISTENT));
+                    return G_SOURCE_REMOVE;
+                },
+                responderCopy,
+                [] (gpointer userData) {
+                    delete reinterpret_cast<http::MicroServer::APIResponder*>(userData);
+                });
+            g_source_attach(timeoutSourcePtr.get(), contextPtr);
+        };
+
+    GMainLoopPtr loopPtr(g_main_loop_new(contextPtr.get(), FALSE));
+    std::thread loopThread;
+    if(options.async) {
+        loopThread = std::thread([context = contextPtr.get(), loop = loopPtr.get()] () {
+            g_main_context_push_thread_default(context);
+            g_main_loop_run(loop);
+            g_main_context_pop_thread_default(context);
+        });
+    }
+
+    const char* path = options.api ? ApiPath : PagePath;
+
+    spdlog::info(
+        "Benchmarking \"{}\" with {} client(s), {}s per run",
+        path,
+        options.clients,
+        options.duration);
+
+    int result = 0;
+    for(unsigned threadPoolSize: threads) {
+        http::Config config {};
+        config.port = options.port;
+        config.wwwRoot = wwwRootPtr.get();
+        config.apiPrefix = ApiPrefix;
+        config.threadPoolSize = threadPoolSize;
+
+        http::MicroServer server(
+            config,
+            std::string(),
+            http::MicroServer::OnNewAuthToken(),
+            apiHandler,
+            contextPtr.get());
+        if(options.async)
+            server.setAsyncAPIRequestHandler(asyncApiHandler);
+        if(!server.init()) {
+            spdlog::critical("Failed to start HTTP server on port {}", options.port);
+            result = -1;
+            break;
+        }
+
+        const RunResult runResult = Run(options, path);
+
+        spdlog::info(
+            "threads: {:>3}, requests/s: {:>9.0f}, errors: {}",
+            threadPoolSize,
+            static_cast<double>(runResult.requests) / options.duration,
+            runResult.errors);
+    }
+
+    if(loopThread.joinable()) {
+        g_main_context_invoke(
+            contextPtr.get(),
+            [] (gpointer userData) -> gboolean {
+                g_main_loop_quit(static_cast<GMainLoop*>(userData));
+                return G_SOURCE_REMOVE;
+            },
+            loopPtr.get());
+        loopThread.join();
+    }
+
+    g_remove(pageFilePtr.get());
+    g_rmdir(wwwRootPtr.get());
+
+    return result;
+}
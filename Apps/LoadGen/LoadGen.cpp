@@ -0,0 +1,454 @@
+#include <thread>
+#include <memory>
+#include <future>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <algorithm>
+
+#include <time.h>
+#include <unistd.h>
+
+#include <CxxPtr/GlibPtr.h>
+
+#include "RtStreaming/GstRtStreaming/LibGst.h"
+#include "RtStreaming/GstRtStreaming/GstTestStreamer2.h"
+#include "RtStreaming/GstRtStreaming/GstClient.h"
+
+#include "Helpers/LwsLog.h"
+
+#include "RtspSession/Log.h"
+#include "RtspSession/ServerSession.h"
+#include "RtspSession/NullPeer.h"
+
+#include "Signalling/Log.h"
+#include "Signalling/WsServer.h"
+
+#include "Client/Log.h"
+#include "Client/WsClient.h"
+
+#include "Stats.h"
+#include "LoadSession.h"
+
+
+namespace {
+
+enum {
+    DEFAULT_PORT = 5554,
+    DEFAULT_CONNECTIONS = 1000,
+    DEFAULT_RATE = 100, // new connections per second
+    DEFAULT_CYCLES = 1, // per connection, 0 - infinite
+    DEFAULT_PINGS = 3, // GET_PARAMETER requests per cycle
+    DEFAULT_PING_INTERVAL = 100, // ms
+    DEFAULT_DURATION = 60, // seconds
+    DEFAULT_REPORT_INTERVAL = 5, // seconds
+    DEFAULT_PREPARE_DELAY = 0, // ms
+    CONNECT_TICK_INTERVAL = 10, // ms
+};
+
+const char *const StreamUri = "LoadGen";
+
+struct Options
+{
+    gint port = DEFAULT_PORT;
+    gint connections = DEFAULT_CONNECTIONS;
+    gint rate = DEFAULT_RATE;
+    gint cycles = DEFAULT_CYCLES;
+    gint pings = DEFAULT_PINGS;
+    gint pingInterval = DEFAULT_PING_INTERVAL;
+    gint duration = DEFAULT_DURATION;
+    gint reportInterval = DEFAULT_REPORT_INTERVAL;
+    gboolean external = FALSE;
+    gboolean useGst = FALSE;
+    gint prepareDelay = DEFAULT_PREPARE_DELAY;
+};
+
+GstTestStreamer2 streamer;
+std::atomic<unsigned> liveServerSessions = 0;
+
+std::unique_ptr<WebRTCPeer> CreateServerPeer(const Options& options)
+{
+    if(options.useGst)
+        return streamer.createPeer();
+
+    rtsp::NullPeer::Config config;
+    config.prepareDelay = std::chrono::milliseconds(options.prepareDelay);
+
+    return std::make_unique<rtsp::NullPeer>(config);
+}
+
+std::unique_ptr<WebRTCPeer> CreateClientPeer(const Options& options)
+{
+    if(options.useGst)
+        return std::make_unique<GstClient>();
+
+    rtsp::NullPeer::Config config;
+    config.prepareDelay = std::chrono::milliseconds(options.prepareDelay);
+
+    return std::make_unique<rtsp::NullPeer>(config);
+}
+
+class CountedServerSession : public rtsp::ServerSession
+{
+public:
+    CountedServerSession(
+        const Options* options,
+        const SendRequest& sendRequest,
+        const SendResponse& sendResponse) noexcept :
+        rtsp::ServerSession(
+            std::make_shared<WebRTCConfig>(),
+            [options] (const std::string&) { return CreateServerPeer(*options); },
+            sendRequest,
+            sendResponse)
+    {
+        ++liveServerSessions;
+    }
+
+    ~CountedServerSession()
+    {
+        --liveServerSessions;
+    }
+};
+
+std::unique_ptr<rtsp::ServerSession> CreateServerSession(
+    const Options* options,
+    const rtsp::Session::SendRequest& sendRequest,
+    const rtsp::Session::SendResponse& sendResponse) noexcept
+{
+    return std::make_unique<CountedServerSession>(options, sendRequest, sendResponse);
+}
+
+size_t ProcessRss()
+{
+    std::ifstream statm("/proc/self/statm");
+
+    size_t size = 0;
+    size_t resident = 0;
+    if(!(statm >> size >> resident))
+        return 0;
+
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+class LoadGen
+{
+public:
+    LoadGen(const Options&, GMainLoop*) noexcept;
+    ~LoadGen();
+
+    void start() noexcept;
+
+private:
+    struct Client
+    {
+        std::unique_ptr<client::WsClient> wsClient;
+        bool established = false;
+        bool cycleCompleted = false;
+        unsigned cycles = 0;
+    };
+
+    std::unique_ptr<rtsp::Session> createSession(
+        Client*,
+        const rtsp::Session::SendRequest&,
+        const rtsp::Session::SendResponse&) noexcept;
+    void disconnected(Client*) noexcept;
+
+    void connectTick() noexcept;
+    void report() noexcept;
+    void stop() noexcept;
+
+    ProcessUsage processUsage() const noexcept;
+
+private:
+    const Options _options;
+    GMainLoop *const _loop;
+
+    const WebRTCConfigPtr _webRTCConfig = std::make_shared<WebRTCConfig>();
+
+    Stats _stats;
+
+    std::deque<std::unique_ptr<Client>> _clients;
+    std::deque<Client*> _pendingConnects;
+    double _connectBudget = 0;
+
+    bool _stopping = false;
+};
+
+LoadGen::LoadGen(
+    const Options& options,
+    GMainLoop* loop) noexcept :
+    _options(options),
+    _loop(loop)
+{
+}
+
+LoadGen::~LoadGen()
+{
+    _stopping = true;
+    _clients.clear();
+}
+
+void LoadGen::start() noexcept
+{
+    client::Config config {
+        .server = "localhost",
+        .serverPort = static_cast<unsigned short>(_options.port),
+        .useTls = false,
+    };
+
+    for(int i = 0; i < _options.connections; ++i) {
+        std::unique_ptr<Client> clientPtr = std::make_unique<Client>();
+        Client* client = clientPtr.get();
+
+        client->wsClient =
+            std::make_unique<client::WsClient>(
+                config,
+                _loop,
+                std::bind(
+                    &LoadGen::createSession,
+                    this,
+                    client,
+                    std::placeholders::_1,
+                    std::placeholders::_2),
+                [this, client] (client::WsClient&) {
+                    disconnected(client);
+                });
+        if(!client->wsClient->init()) {
+            spdlog::critical("Failed to init WebSocket client");
+            g_main_loop_quit(_loop);
+            return;
+        }
+
+        _pendingConnects.push_back(client);
+        _clients.emplace_back(std::move(clientPtr));
+    }
+
+    g_timeout_add_full(
+        G_PRIORITY_DEFAULT,
+        CONNECT_TICK_INTERVAL,
+        [] (gpointer userData) -> gboolean {
+            static_cast<LoadGen*>(userData)->connectTick();
+            return G_SOURCE_CONTINUE;
+        },
+        this,
+        nullptr);
+    g_timeout_add_seconds(
+        _options.reportInterval,
+        [] (gpointer userData) -> gboolean {
+            static_cast<LoadGen*>(userData)->report();
+            return G_SOURCE_CONTINUE;
+        },
+        this);
+    g_timeout_add_seconds(
+        _options.duration,
+        [] (gpointer userData) -> gboolean {
+            static_cast<LoadGen*>(userData)->stop();
+            return G_SOURCE_REMOVE;
+        },
+        this);
+}
+
+std::unique_ptr<rtsp::Session> LoadGen::createSession(
+    Client* client,
+    const rtsp::Session::SendRequest& sendRequest,
+    const rtsp::Session::SendResponse& sendResponse) noexcept
+{
+    client->established = true;
+    client->cycleCompleted = false;
+
+    _stats.onConnected();
+
+    std::shared_ptr<LoadSession::SentRequests> sentRequests =
+        std::make_shared<LoadSession::SentRequests>();
+
+    return
+        std::make_unique<LoadSession>(
+            StreamUri,
+            LoadSession::Script {
+                .pings = static_cast<unsigned>(_options.pings),
+                .pingInterval = std::chrono::milliseconds(_options.pingInterval) },
+            &_stats,
+            sentRequests,
+            [this, client] () {
+                client->cycleCompleted = true;
+                ++client->cycles;
+                _stats.onCycleCompleted();
+            },
+            _webRTCConfig,
+            [options = &_options] () { return CreateClientPeer(*options); },
+            [sentRequests, sendRequest] (const rtsp::Request* request) {
+                if(request)
+                    (*sentRequests)[request->cseq] = Stats::Clock::now();
+                sendRequest(request);
+            },
+            sendResponse);
+}
+
+void LoadGen::disconnected(Client* client) noexcept
+{
+    if(_stopping)
+        return;
+
+    if(client->established)
+        _stats.onDisconnected(client->cycleCompleted);
+    else
+        _stats.onConnectFailed();
+
+    client->established = false;
+
+    if(_options.cycles == 0 || client->cycles < static_cast<unsigned>(_options.cycles))
+        _pendingConnects.push_back(client);
+}
+
+void LoadGen::connectTick() noexcept
+{
+    _connectBudget += _options.rate * CONNECT_TICK_INTERVAL / 1000.;
+
+    while(_connectBudget >= 1 && !_pendingConnects.empty()) {
+        Client* client = _pendingConnects.front();
+        _pendingConnects.pop_front();
+
+        client->wsClient->connect();
+
+        _connectBudget -= 1;
+    }
+
+    if(_pendingConnects.empty())
+        _connectBudget = std::min(_connectBudget, 1.);
+}
+
+ProcessUsage LoadGen::processUsage() const noexcept
+{
+    ProcessUsage usage;
+
+    usage.rss = ProcessRss();
+
+    timespec cpuTime;
+    if(0 == clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuTime)) {
+        usage.cpuTime =
+            std::chrono::seconds(cpuTime.tv_sec) +
+            std::chrono::nanoseconds(cpuTime.tv_nsec);
+    }
+
+    return usage;
+}
+
+void LoadGen::report() noexcept
+{
+    _stats.report(
+        processUsage(),
+        _options.external ? std::nullopt : std::optional<unsigned>(liveServerSessions));
+}
+
+void LoadGen::stop() noexcept
+{
+    report();
+
+    g_main_loop_quit(_loop);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    GOptionEntry entries[] = {
+        { "port", 'p', 0, G_OPTION_ARG_INT, &options.port, "WebRTSP server port", "PORT" },
+        { "connections", 'c', 0, G_OPTION_ARG_INT, &options.connections, "Concurrent connections", "N" },
+        { "rate", 'r', 0, G_OPTION_ARG_INT, &options.rate, "New connections per second", "N" },
+        { "cycles", 0, 0, G_OPTION_ARG_INT, &options.cycles, "Cycles per connection (0 - infinite)", "N" },
+        { "pings", 0, 0, G_OPTION_ARG_INT, &options.pings, "GET_PARAMETER requests per cycle", "N" },
+        { "ping-interval", 0, 0, G_OPTION_ARG_INT, &options.pingInterval, "Interval between GET_PARAMETER requests", "MS" },
+        { "duration", 'd', 0, G_OPTION_ARG_INT, &options.duration, "Test duration", "SECONDS" },
+        { "report-interval", 0, 0, G_OPTION_ARG_INT, &options.reportInterval, "Report interval", "SECONDS" },
+        { "external", 'e', 0, G_OPTION_ARG_NONE, &options.external, "Don't start embedded server", nullptr },
+        { "gst", 'g', 0, G_OPTION_ARG_NONE, &options.useGst, "Use GStreamer peers instead of NullPeer", nullptr },
+        { "prepare-delay", 0, 0, G_OPTION_ARG_INT, &options.prepareDelay, "Simulated NullPeer prepare delay", "MS" },
+        { nullptr }
+    };
+
+    g_autoptr(GOptionContext) optionContext =
+        g_option_context_new("- WebRTSP signalling load generator");
+    g_option_context_add_main_entries(optionContext, entries, nullptr);
+    g_autoptr(GError) error = nullptr;
+    if(!g_option_context_parse(optionContext, &argc, &argv, &error)) {
+        spdlog::critical("Failed to parse options: {}", error->message);
+        return -1;
+    }
+
+    if(options.port <= 0 || options.connections <= 0 || options.rate <= 0 ||
+        options.cycles < 0 || options.pings < 0 || options.pingInterval < 0 ||
+        options.duration <= 0 || options.reportInterval <= 0 || options.prepareDelay < 0)
+    {
+        spdlog::critical("Invalid options");
+        return -1;
+    }
+
+    LibGst libGst;
+
+    InitLwsLogger(spdlog::level::warn);
+    InitWsServerLogger(spdlog::level::warn);
+    InitWsClientLogger(spdlog::level::warn);
+    InitRtspSessionLogger(spdlog::level::warn);
+    InitServerSessionLogger(spdlog::level::warn);
+    InitClientSessionLogger(spdlog::level::warn);
+
+    GMainContextPtr serverContextPtr(g_main_context_new());
+    GMainContext* serverContext = serverContextPtr.get();
+    GMainLoopPtr serverLoopPtr(g_main_loop_new(serverContext, FALSE));
+    GMainLoop* serverLoop = serverLoopPtr.get();
+
+    std::thread serverThread;
+    if(!options.external) {
+        std::promise<bool> serverStarted;
+        std::future<bool> serverStartedFuture = serverStarted.get_future();
+
+        serverThread = std::thread(
+            [&options, serverContext, serverLoop, &serverStarted] () {
+                g_main_context_push_thread_default(serverContext);
+
+                signalling::Config config {};
+                config.port = options.port;
+
+                signalling::WsServer server(
+                    config,
+                    serverLoop,
+                    std::bind(
+                        CreateServerSession,
+                        &options,
+                        std::placeholders::_1,
+                        std::placeholders::_2));
+
+                const bool initialized = server.init();
+                serverStarted.set_value(initialized);
+                if(initialized)
+                    g_main_loop_run(serverLoop);
+
+                g_main_context_pop_thread_default(serverContext);
+            });
+
+        if(!serverStartedFuture.get()) {
+            spdlog::critical("Failed to start embedded server");
+            serverThread.join();
+            return -1;
+        }
+    }
+
+    GMainLoopPtr loopPtr(g_main_loop_new(nullptr, FALSE));
+    GMainLoop* loop = loopPtr.get();
+
+    {
+        LoadGen loadGen(options, loop);
+        loadGen.start();
+
+        g_main_loop_run(loop);
+    }
+
+    if(serverThread.joinable()) {
+        g_main_loop_quit(serverLoop);
+        serverThread.join();
+    }
+
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include "LoadSession.h"
+
+
+LoadSession::LoadSession(
+    const std::string& uri,
+    const Script& script,
+    Stats* stats,
+    const std::shared_ptr<SentRequests>& sentRequests,
+    const CycleCompleted& cycleCompleted,
+    const WebRTCConfigPtr& webRTCConfig,
+    const CreatePeer& createPeer,
+    const SendRequest& sendRequest,
+    const SendResponse& sendResponse) noexcept :
+    rtsp::ScriptedClientSession(
+        uri,
+        script,
+        rtsp::NullPeer::GlibSchedule(),
+        cycleCompleted,
+        webRTCConfig,
+        createPeer,
+        sendRequest,
+        sendResponse),
+    _stats(stats),
+    _sentRequests(sentRequests)
+{
+}
+
+bool LoadSession::handleResponse(
+    const rtsp::Request& request,
+    std::unique_ptr<rtsp::Response>&& responsePtr) noexcept
+{
+    auto it = _sentRequests->find(request.cseq);
+    if(it != _sentRequests->end()) {
+        _stats->onResponse(
+            request.method,
+            Stats::Clock::now() - it->second,
+            responsePtr->statusCode);
+        _sentRequests->erase(it);
+    }
+
+    return rtsp::ScriptedClientSession::handleResponse(request, std::move(responsePtr));
+}
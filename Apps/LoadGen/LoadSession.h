@@ -0,0 +1,36 @@
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include "RtspSession/ScriptedClientSession.h"
+
+#include "Stats.h"
+
+
+// Scripted cycle on real clock, response latencies are collected to Stats
+class LoadSession : public rtsp::ScriptedClientSession
+{
+public:
+    typedef std::map<rtsp::CSeq, Stats::Clock::time_point> SentRequests;
+
+    LoadSession(
+        const std::string& uri,
+        const Script&,
+        Stats*,
+        const std::shared_ptr<SentRequests>&,
+        const CycleCompleted&,
+        const WebRTCConfigPtr&,
+        const CreatePeer& createPeer,
+        const SendRequest& sendRequest,
+        const SendResponse& sendResponse) noexcept;
+
+protected:
+    bool handleResponse(
+        const rtsp::Request&,
+        std::unique_ptr<rtsp::Response>&&) noexcept override;
+
+private:
+    Stats *const _stats;
+    const std::shared_ptr<SentRequests> _sentRequests;
+};
@@ -0,0 +1,125 @@
+#include "Stats.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+
+namespace {
+
+double Percentile(const std::vector<double>& sortedSamples, double percentile)
+{
+    if(sortedSamples.empty())
+        return 0;
+
+    const size_t index =
+        std::min(
+            sortedSamples.size() - 1,
+            static_cast<size_t>(percentile / 100 * sortedSamples.size()));
+
+    return sortedSamples[index];
+}
+
+}
+
+Stats::Stats() noexcept :
+    _startTime(Clock::now()),
+    _lastReportTime(_startTime)
+{
+}
+
+void Stats::onConnected() noexcept
+{
+    ++_activeConnections;
+    ++_totalConnections;
+}
+
+void Stats::onConnectFailed() noexcept
+{
+    ++_connectFailures;
+}
+
+void Stats::onDisconnected(bool cycleCompleted) noexcept
+{
+    --_activeConnections;
+
+    if(!cycleCompleted)
+        ++_droppedConnections;
+}
+
+void Stats::onCycleCompleted() noexcept
+{
+    ++_completedCycles;
+}
+
+void Stats::onResponse(
+    rtsp::Method method,
+    Clock::duration latency,
+    unsigned statusCode) noexcept
+{
+    MethodStats& methodStats = _methods[method];
+
+    ++methodStats.responses;
+    methodStats.intervalLatencies.push_back(
+        std::chrono::duration<double, std::milli>(latency).count());
+
+    if(statusCode != 200)
+        ++methodStats.errors;
+}
+
+void Stats::report(
+    const ProcessUsage& processUsage,
+    const std::optional<unsigned>& liveServerSessions) noexcept
+{
+    const Clock::time_point now = Clock::now();
+    const double elapsed = std::chrono::duration<double>(now - _startTime).count();
+    const double sinceLastReport = std::chrono::duration<double>(now - _lastReportTime).count();
+
+    const double cpuLoad = sinceLastReport > 0 ?
+        std::chrono::duration<double>(processUsage.cpuTime - _lastProcessUsage.cpuTime).count() /
+            sinceLastReport * 100 :
+        0;
+
+    spdlog::info(
+        "[{:.1f}s] connections: {} active, {} total, {} connect failures, {} dropped; cycles completed: {}",
+        elapsed,
+        _activeConnections,
+        _totalConnections,
+        _connectFailures,
+        _droppedConnections,
+        _completedCycles);
+    if(liveServerSessions)
+        spdlog::info("[{:.1f}s] embedded server: {} live sessions", elapsed, *liveServerSessions);
+    // clients and server share the process, so it's not possible to tell server share apart
+    spdlog::info(
+        "[{:.1f}s] process total ({}): CPU {:.1f}%, RSS {} KiB",
+        elapsed,
+        liveServerSessions ? "clients and embedded server" : "clients only",
+        cpuLoad,
+        processUsage.rss / 1024);
+
+    // percentiles are per report interval, so only latencies since last report are kept
+    for(auto& pair: _methods) {
+        std::vector<double>& latencies = pair.second.intervalLatencies;
+        std::sort(latencies.begin(), latencies.end());
+
+        spdlog::info(
+            "[{:.1f}s] {:>13}: {:>8} responses, {:>6} errors; last {:.1f}s: {:>6} responses, "
+            "p50 {:.2f} ms, p90 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms",
+            elapsed,
+            rtsp::MethodName(pair.first),
+            pair.second.responses,
+            pair.second.errors,
+            sinceLastReport,
+            latencies.size(),
+            Percentile(latencies, 50),
+            Percentile(latencies, 90),
+            Percentile(latencies, 99),
+            latencies.empty() ? 0 : latencies.back());
+
+        latencies.clear();
+    }
+
+    _lastReportTime = now;
+    _lastProcessUsage = processUsage;
+}
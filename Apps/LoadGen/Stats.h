@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "RtspParser/Methods.h"
+
+
+// whole load generator process, including embedded server if any
+struct ProcessUsage
+{
+    std::chrono::nanoseconds cpuTime = {}; // all threads
+    size_t rss = 0; // bytes
+};
+
+class Stats
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    Stats() noexcept;
+
+    void onConnected() noexcept;
+    void onConnectFailed() noexcept;
+    void onDisconnected(bool cycleCompleted) noexcept;
+    void onCycleCompleted() noexcept;
+    void onResponse(rtsp::Method, Clock::duration latency, unsigned statusCode) noexcept;
+
+    // liveServerSessions is empty if there is no embedded server
+    void report(const ProcessUsage&, const std::optional<unsigned>& liveServerSessions) noexcept;
+
+private:
+    struct MethodStats {
+        std::vector<double> intervalLatencies; // ms, since last report
+        unsigned responses = 0;
+        unsigned errors = 0;
+    };
+
+    const Clock::time_point _startTime;
+    Clock::time_point _lastReportTime;
+    ProcessUsage _lastProcessUsage;
+
+    unsigned _activeConnections = 0;
+    unsigned _totalConnections = 0;
+    unsigned _connectFailures = 0;
+    unsigned _droppedConnections = 0;
+    unsigned _completedCycles = 0;
+
+    std::map<rtsp::Method, MethodStats> _methods;
+};
@@ -0,0 +1,182 @@
+#include <cstdio>
+#include <functional>
+
+#include <sys/resource.h>
+
+#include <glib.h>
+#include <gst/gst.h>
+
+#include <QGuiApplication>
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQmlExtensionPlugin>
+#include <QTimer>
+
+#include "Qt/QML/QmlLibGst.h"
+
+
+Q_IMPORT_QML_PLUGIN(org_webrtsp_clientPlugin)
+
+namespace {
+
+enum {
+    DEFAULT_VIEWS = 16,
+    DEFAULT_HIDDEN = 12,
+    DEFAULT_WARMUP = 10, // seconds
+    DEFAULT_DURATION = 30, // seconds
+};
+
+struct Options
+{
+    gchar* serverUrl = nullptr;
+    gchar* uri = nullptr;
+    gint views = DEFAULT_VIEWS;
+    gint hidden = DEFAULT_HIDDEN;
+    gint warmup = DEFAULT_WARMUP;
+    gint duration = DEFAULT_DURATION;
+};
+
+const char* BenchQml = R"(
+import QtQuick
+import QtQuick.Window
+import org.freedesktop.gstreamer.Qt6GLVideoItem
+import org.webrtsp.client
+
+Window {
+    id: window
+    width: 1280
+    height: 720
+    visible: true
+
+    property var players: []
+
+    function setSuspendHidden(suspendHidden) {
+        for(const player of players)
+            player.suspendHidden = suspendHidden
+    }
+
+    WebRTSPConnection {
+        id: connection
+        serverUrl: benchServerUrl
+        Component.onCompleted: open()
+    }
+
+    Grid {
+        anchors.fill: parent
+        columns: Math.max(1, Math.ceil(Math.sqrt(benchViews - benchHidden)))
+
+        Repeater {
+            model: benchViews
+
+            GstGLQt6VideoItem {
+                width: window.width / parent.columns
+                height: window.height / parent.columns
+                visible: index < benchViews - benchHidden
+                Component.onCompleted: window.players.push(connection.player(benchUri, this))
+            }
+        }
+    }
+}
+)";
+
+double CpuSeconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return
+        usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+        usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// warms up, then measures CPU load during duration
+void Measure(
+    QObject* window,
+    bool suspendHidden,
+    const Options& options,
+    const std::function<void (double load)>& finished)
+{
+    QMetaObject::invokeMethod(window, "setSuspendHidden", Q_ARG(QVariant, QVariant(suspendHidden)));
+
+    QTimer::singleShot(options.warmup * 1000, [options, finished] () {
+        const double cpuStart = CpuSeconds();
+        QTimer::singleShot(options.duration * 1000, [options, finished, cpuStart] () {
+            finished((CpuSeconds() - cpuStart) / options.duration * 100);
+        });
+    });
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    GOptionEntry entries[] = {
+        { "server", 's', 0, G_OPTION_ARG_STRING, &options.serverUrl, "WebRTSP server url", "URL" },
+        { "uri", 'u', 0, G_OPTION_ARG_STRING, &options.uri, "Streamer uri every view plays", "URI" },
+        { "views", 'v', 0, G_OPTION_ARG_INT, &options.views, "Players count", "N" },
+        { "hidden", 'H', 0, G_OPTION_ARG_INT, &options.hidden, "Players with invisible view", "N" },
+        { "warmup", 'w', 0, G_OPTION_ARG_INT, &options.warmup, "Seconds before measurement start", "SECONDS" },
+        { "duration", 'd', 0, G_OPTION_ARG_INT, &options.duration, "Measurement duration", "SECONDS" },
+        { nullptr }
+    };
+
+    g_autoptr(GOptionContext) optionContext =
+        g_option_context_new("- WebRTSPPlayer decode suspension benchmark");
+    g_option_context_add_main_entries(optionContext, entries, nullptr);
+    g_autoptr(GError) error = nullptr;
+    if(!g_option_context_parse(optionContext, &argc, &argv, &error)) {
+        fprintf(stderr, "Failed to parse options: %s\n", error->message);
+        return -1;
+    }
+
+    if(!options.serverUrl || !options.uri ||
+        options.views <= 0 || options.hidden < 0 || options.hidden >= options.views ||
+        options.warmup < 0 || options.duration <= 0)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return -1;
+    }
+
+    QmlLibGst libGst;
+
+    // qml6glsink has to be loaded before QML engine to register GstGLQt6VideoItem
+    GstElement* sink = gst_element_factory_make("qml6glsink", nullptr);
+    if(!sink) {
+        fprintf(stderr, "qml6glsink is not available\n");
+        return -1;
+    }
+    gst_object_unref(sink);
+
+    QGuiApplication app(argc, argv);
+
+    QQmlApplicationEngine engine;
+    engine.rootContext()->setContextProperty("benchServerUrl", QUrl(options.serverUrl));
+    engine.rootContext()->setContextProperty("benchUri", QString(options.uri));
+    engine.rootContext()->setContextProperty("benchViews", options.views);
+    engine.rootContext()->setContextProperty("benchHidden", options.hidden);
+    engine.loadData(BenchQml);
+    if(engine.rootObjects().isEmpty())
+        return -1;
+
+    QObject* window = engine.rootObjects().first();
+
+    printf(
+        "%d view(s), %d hidden, %ds warmup, %ds measurement\n",
+        options.views,
+        options.hidden,
+        options.warmup,
+        options.duration);
+
+    Measure(window, false, options, [window, &options] (double decodingLoad) {
+        printf("%-20s CPU: %6.1f%%\n", "all decoding", decodingLoad);
+        Measure(window, true, options, [decodingLoad] (double suspendedLoad) {
+            printf("%-20s CPU: %6.1f%%\n", "hidden suspended", suspendedLoad);
+            printf("%-20s %6.1f%%\n", "saved", decodingLoad - suspendedLoad);
+            QCoreApplication::quit();
+        });
+    });
+
+    return app.exec();
+}
@@ -0,0 +1,37 @@
+#include "EventQueue.h"
+
+#include <algorithm>
+
+
+void EventQueue::schedule(Duration delay, const Action& action) noexcept
+{
+    scheduleAt(_now + std::max(delay, Duration::zero()), action);
+}
+
+void EventQueue::scheduleAt(TimePoint time, const Action& action) noexcept
+{
+    _events.push(Event { std::max(time, _now), _nextSeq++, action });
+}
+
+bool EventQueue::step() noexcept
+{
+    if(_events.empty())
+        return false;
+
+    // action can schedule new events, so it have to be moved out before pop
+    Event event = std::move(const_cast<Event&>(_events.top()));
+    _events.pop();
+
+    _now = event.time;
+    ++_dispatched;
+
+    event.action();
+
+    return true;
+}
+
+void EventQueue::run(TimePoint until) noexcept
+{
+    while(!_events.empty() && _events.top().time <= until)
+        step();
+}
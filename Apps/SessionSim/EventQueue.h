@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <vector>
+
+
+// Single threaded event queue driven by virtual clock.
+// Events with equal time are dispatched in scheduling order,
+// so simulation is fully deterministic.
+class EventQueue
+{
+public:
+    typedef std::chrono::microseconds Duration;
+    typedef Duration TimePoint; // since simulation start
+    typedef std::function<void ()> Action;
+
+    TimePoint now() const noexcept { return _now; }
+
+    void schedule(Duration delay, const Action&) noexcept;
+    void scheduleAt(TimePoint, const Action&) noexcept;
+
+    bool empty() const noexcept { return _events.empty(); }
+    size_t dispatched() const noexcept { return _dispatched; }
+
+    // returns false if queue is empty
+    bool step() noexcept;
+    // dispatches events until queue is empty or virtual time reaches limit
+    void run(TimePoint until = TimePoint::max()) noexcept;
+
+private:
+    struct Event
+    {
+        TimePoint time;
+        uint64_t seq;
+        Action action;
+    };
+
+    struct Later
+    {
+        bool operator() (const Event& l, const Event& r) const noexcept
+        {
+            return l.time != r.time ? l.time > r.time : l.seq > r.seq;
+        }
+    };
+
+    TimePoint _now = TimePoint::zero();
+    uint64_t _nextSeq = 0;
+    size_t _dispatched = 0;
+
+    std::priority_queue<Event, std::vector<Event>, Later> _events;
+};
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <glib.h>
+
+#include <spdlog/spdlog.h>
+
+#include "RtspSession/Log.h"
+#include "RtspSession/ServerSession.h"
+#include "RtspSession/NullPeer.h"
+
+#include "EventQueue.h"
+#include "SimLink.h"
+#include "SimClientSession.h"
+
+
+namespace {
+
+enum {
+    DEFAULT_CONNECTIONS = 10000,
+    DEFAULT_CONCURRENCY = 1000,
+    DEFAULT_LATENCY = 20, // ms
+    DEFAULT_JITTER = 0, // ms
+    DEFAULT_SEED = 1,
+    DEFAULT_PINGS = 3,
+    DEFAULT_PING_INTERVAL = 1000, // ms
+    DEFAULT_RESPONSE_TIMEOUT = 5000, // ms
+    DEFAULT_PREPARE_DELAY = 50, // ms
+};
+
+const char *const SimUri = "sim://test";
+
+struct Options
+{
+    gint connections = DEFAULT_CONNECTIONS;
+    gint concurrency = DEFAULT_CONCURRENCY;
+    gint latency = DEFAULT_LATENCY;
+    gint jitter = DEFAULT_JITTER;
+    gboolean reorder = FALSE;
+    gdouble disconnectProbability = 0;
+    gint seed = DEFAULT_SEED;
+    gint pings = DEFAULT_PINGS;
+    gint pingInterval = DEFAULT_PING_INTERVAL;
+    gint responseTimeout = DEFAULT_RESPONSE_TIMEOUT;
+    gint prepareDelay = DEFAULT_PREPARE_DELAY;
+};
+
+class Simulation
+{
+public:
+    Simulation(const Options&) noexcept;
+
+    void run() noexcept;
+    void report(std::chrono::steady_clock::duration wallTime) noexcept;
+
+private:
+    void startLink() noexcept;
+    void onLinkClosed(unsigned linkId, SimLink::CloseReason) noexcept;
+
+    rtsp::NullPeer::Schedule peerSchedule() noexcept;
+
+private:
+    const Options _options;
+    const WebRTCConfigPtr _webRTCConfig;
+
+    EventQueue _queue;
+    std::mt19937 _random;
+
+    unsigned _nextLinkId = 0;
+    std::map<unsigned, std::unique_ptr<SimLink>> _links;
+    unsigned _messagesDelivered = 0;
+
+    unsigned _completedCycles = 0;
+    unsigned _timeouts = 0;
+    std::map<SimLink::CloseReason, unsigned> _closeReasons;
+    std::map<rtsp::Method, std::vector<EventQueue::Duration::rep>> _latencies;
+};
+
+Simulation::Simulation(const Options& options) noexcept :
+    _options(options),
+    _webRTCConfig(std::make_shared<WebRTCConfig>()),
+    _random(options.seed)
+{
+}
+
+rtsp::NullPeer::Schedule Simulation::peerSchedule() noexcept
+{
+    return [this] (std::chrono::milliseconds delay, const rtsp::NullPeer::Action& action) {
+        _queue.schedule(delay, action);
+    };
+}
+
+void Simulation::startLink() noexcept
+{
+    const unsigned linkId = _nextLinkId++;
+
+    rtsp::NullPeer::Config peerConfig;
+    peerConfig.prepareDelay = std::chrono::milliseconds(_options.prepareDelay);
+
+    const SimLink::Config linkConfig {
+        .latency = std::chrono::milliseconds(_options.latency),
+        .jitter = std::chrono::milliseconds(_options.jitter),
+        .reorder = _options.reorder != FALSE,
+        .disconnectProbability = _options.disconnectProbability };
+
+    const SimClientSession::Script script {
+        .pings = static_cast<unsigned>(_options.pings),
+        .pingInterval = std::chrono::milliseconds(_options.pingInterval) };
+    const EventQueue::Duration responseTimeout = std::chrono::milliseconds(_options.responseTimeout);
+
+    const SimClientSession::Callbacks callbacks {
+        .response = [this] (rtsp::Method method, EventQueue::Duration latency, unsigned) {
+            _latencies[method].push_back(latency.count());
+        },
+        .timeout = [this] (rtsp::Method) {
+            ++_timeouts;
+        },
+        .cycleCompleted = [this] () {
+            ++_completedCycles;
+        } };
+
+    std::unique_ptr<SimLink>& link = _links[linkId];
+    link = std::make_unique<SimLink>(
+        &_queue,
+        &_random,
+        linkConfig,
+        [this, peerConfig] (
+            const rtsp::Session::SendRequest& sendRequest,
+            const rtsp::Session::SendResponse& sendResponse)
+        {
+            return std::make_unique<rtsp::ServerSession>(
+                _webRTCConfig,
+                [this, peerConfig] (const std::string&) {
+                    return std::make_unique<rtsp::NullPeer>(peerConfig, peerSchedule());
+                },
+                sendRequest,
+                sendResponse);
+        },
+        [this, peerConfig, script, responseTimeout, callbacks] (
+            const rtsp::Session::SendRequest& sendRequest,
+            const rtsp::Session::SendResponse& sendResponse)
+        {
+            return std::make_unique<SimClientSession>(
+                &_queue,
+                SimUri,
+                script,
+                responseTimeout,
+                callbacks,
+                _webRTCConfig,
+                [this, peerConfig] () {
+                    return std::make_unique<rtsp::NullPeer>(peerConfig, peerSchedule());
+                },
+                sendRequest,
+                sendResponse);
+        },
+        std::bind(&Simulation::onLinkClosed, this, linkId, std::placeholders::_1));
+
+    link->connect();
+}
+
+void Simulation::onLinkClosed(unsigned linkId, SimLink::CloseReason reason) noexcept
+{
+    ++_closeReasons[reason];
+
+    auto it = _links.find(linkId);
+    if(it != _links.end()) {
+        _messagesDelivered += it->second->messagesDelivered();
+        _links.erase(it);
+    }
+
+    if(_nextLinkId < static_cast<unsigned>(_options.connections))
+        startLink();
+}
+
+void Simulation::run() noexcept
+{
+    const unsigned initialLinks =
+        std::min(_options.concurrency, _options.connections);
+    for(unsigned i = 0; i < initialLinks; ++i)
+        startLink();
+
+    _queue.run();
+}
+
+void Simulation::report(std::chrono::steady_clock::duration wallTime) noexcept
+{
+    const double wallSeconds = std::chrono::duration<double>(wallTime).count();
+    const double virtualSeconds = std::chrono::duration<double>(_queue.now()).count();
+
+    spdlog::info(
+        "connections: {}, completed cycles: {}, timeouts: {}, "
+        "closed by client/server/injected: {}/{}/{}",
+        _nextLinkId,
+        _completedCycles,
+        _timeouts,
+        _closeReasons[SimLink::CloseReason::Client],
+        _closeReasons[SimLink::CloseReason::Server],
+        _closeReasons[SimLink::CloseReason::Injected]);
+    spdlog::info(
+        "wall time: {:.3f}s, virtual time: {:.3f}s, events: {}, messages: {}, {:.0f} connections/s",
+        wallSeconds,
+        virtualSeconds,
+        _queue.dispatched(),
+        _messagesDelivered,
+        wallSeconds > 0 ? _nextLinkId / wallSeconds : 0.);
+
+    for(auto& [method, latencies]: _latencies) {
+        if(latencies.empty())
+            continue;
+
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies] (double p) {
+            return latencies[static_cast<size_t>(p * (latencies.size() - 1))] / 1000.;
+        };
+
+        spdlog::info(
+            "{}: count {}, p50 {:.1f}ms, p99 {:.1f}ms, max {:.1f}ms",
+            rtsp::MethodName(method),
+            latencies.size(),
+            percentile(0.5),
+            percentile(0.99),
+            latencies.back() / 1000.);
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    GOptionEntry entries[] = {
+        { "connections", 'c', 0, G_OPTION_ARG_INT, &options.connections, "Total simulated connections", "N" },
+        { "concurrency", 'n', 0, G_OPTION_ARG_INT, &options.concurrency, "Concurrent connections", "N" },
+        { "latency", 'l', 0, G_OPTION_ARG_INT, &options.latency, "One way link latency", "MS" },
+        { "jitter", 'j', 0, G_OPTION_ARG_INT, &options.jitter, "Max additional random latency", "MS" },
+        { "reorder", 0, 0, G_OPTION_ARG_NONE, &options.reorder, "Allow messages reordering", nullptr },
+        { "disconnect-probability", 0, 0, G_OPTION_ARG_DOUBLE, &options.disconnectProbability, "Connection loss probability per message", "P" },
+        { "seed", 's', 0, G_OPTION_ARG_INT, &options.seed, "Random seed", "N" },
+        { "pings", 0, 0, G_OPTION_ARG_INT, &options.pings, "GET_PARAMETER requests per cycle", "N" },
+        { "ping-interval", 0, 0, G_OPTION_ARG_INT, &options.pingInterval, "Interval between GET_PARAMETER requests", "MS" },
+        { "response-timeout", 0, 0, G_OPTION_ARG_INT, &options.responseTimeout, "Client response timeout", "MS" },
+        { "prepare-delay", 0, 0, G_OPTION_ARG_INT, &options.prepareDelay, "Simulated peer prepare delay", "MS" },
+        { nullptr }
+    };
+
+    g_autoptr(GOptionContext) optionContext =
+        g_option_context_new("- WebRTSP sessions deterministic simulation");
+    g_option_context_add_main_entries(optionContext, entries, nullptr);
+    g_autoptr(GError) error = nullptr;
+    if(!g_option_context_parse(optionContext, &argc, &argv, &error)) {
+        spdlog::critical("Failed to parse options: {}", error->message);
+        return -1;
+    }
+
+    if(options.connections <= 0 || options.concurrency <= 0 ||
+        options.latency < 0 || options.jitter < 0 ||
+        options.disconnectProbability < 0 || options.disconnectProbability > 1 ||
+        options.pings < 0 || options.pingInterval < 0 ||
+        options.responseTimeout <= 0 || options.prepareDelay < 0)
+    {
+        spdlog::critical("Invalid options");
+        return -1;
+    }
+
+    InitRtspSessionLogger(spdlog::level::critical);
+    InitServerSessionLogger(spdlog::level::critical);
+    InitClientSessionLogger(spdlog::level::critical);
+
+    Simulation simulation(options);
+
+    const auto startTime = std::chrono::steady_clock::now();
+    simulation.run();
+    simulation.report(std::chrono::steady_clock::now() - startTime);
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "SimClientSession.h"
+
+
+SimClientSession::SimClientSession(
+    EventQueue* queue,
+    const std::string& uri,
+    const Script& script,
+    EventQueue::Duration responseTimeout,
+    const Callbacks& callbacks,
+    const WebRTCConfigPtr& webRTCConfig,
+    const CreatePeer& createPeer,
+    const SendRequest& sendRequest,
+    const SendResponse& sendResponse) noexcept :
+    rtsp::ScriptedClientSession(
+        uri,
+        script,
+        [queue] (std::chrono::milliseconds delay, const rtsp::NullPeer::Action& action) {
+            queue->schedule(delay, action);
+        },
+        callbacks.cycleCompleted,
+        webRTCConfig,
+        createPeer,
+        [this, sendRequest] (const rtsp::Request* request) {
+            if(request)
+                onRequestSent(*request);
+            sendRequest(request);
+        },
+        sendResponse),
+    _queue(queue),
+    _responseTimeout(responseTimeout),
+    _callbacks(callbacks)
+{
+}
+
+void SimClientSession::onRequestSent(const rtsp::Request& request) noexcept
+{
+    _pendingRequests.emplace(
+        request.cseq,
+        std::make_pair(request.method, _queue->now()));
+
+    _queue->schedule(
+        _responseTimeout,
+        [weakSelf = weakSelf(), cseq = request.cseq] () {
+            if(std::shared_ptr<ScriptedClientSession*> self = weakSelf.lock())
+                static_cast<SimClientSession*>(*self)->onResponseTimeout(cseq);
+        });
+}
+
+void SimClientSession::onResponseTimeout(rtsp::CSeq cseq) noexcept
+{
+    auto it = _pendingRequests.find(cseq);
+    if(it == _pendingRequests.end())
+        return;
+
+    const rtsp::Method method = it->second.first;
+    _pendingRequests.erase(it);
+
+    if(_callbacks.timeout)
+        _callbacks.timeout(method);
+
+    disconnect();
+}
+
+bool SimClientSession::handleResponse(
+    const rtsp::Request& request,
+    std::unique_ptr<rtsp::Response>&& responsePtr) noexcept
+{
+    auto it = _pendingRequests.find(request.cseq);
+    if(it != _pendingRequests.end()) {
+        if(_callbacks.response) {
+            _callbacks.response(
+                request.method,
+                _queue->now() - it->second.second,
+                responsePtr->statusCode);
+        }
+        _pendingRequests.erase(it);
+    }
+
+    return rtsp::ScriptedClientSession::handleResponse(request, std::move(responsePtr));
+}
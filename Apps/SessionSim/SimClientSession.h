@@ -0,0 +1,49 @@
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include "RtspSession/ScriptedClientSession.h"
+
+#include "EventQueue.h"
+
+
+// Scripted cycle driven by virtual clock.
+// Every request is guarded by response timeout.
+class SimClientSession : public rtsp::ScriptedClientSession
+{
+public:
+    struct Callbacks
+    {
+        std::function<void (rtsp::Method, EventQueue::Duration latency, unsigned statusCode)> response;
+        std::function<void (rtsp::Method)> timeout;
+        std::function<void ()> cycleCompleted;
+    };
+
+    SimClientSession(
+        EventQueue*,
+        const std::string& uri,
+        const Script&,
+        EventQueue::Duration responseTimeout,
+        const Callbacks&,
+        const WebRTCConfigPtr&,
+        const CreatePeer& createPeer,
+        const SendRequest& sendRequest,
+        const SendResponse& sendResponse) noexcept;
+
+protected:
+    bool handleResponse(
+        const rtsp::Request&,
+        std::unique_ptr<rtsp::Response>&&) noexcept override;
+
+private:
+    void onRequestSent(const rtsp::Request&) noexcept;
+    void onResponseTimeout(rtsp::CSeq) noexcept;
+
+private:
+    EventQueue *const _queue;
+    const EventQueue::Duration _responseTimeout;
+    const Callbacks _callbacks;
+
+    std::map<rtsp::CSeq, std::pair<rtsp::Method, EventQueue::TimePoint>> _pendingRequests;
+};
@@ -0,0 +1,253 @@
+#include "SimLink.h"
+
+#include <algorithm>
+
+#include "RtspParser/RtspParser.h"
+#include "RtspParser/RtspSerialize.h"
+
+
+struct SimLink::Private
+{
+    enum Side {
+        ClientSide,
+        ServerSide,
+    };
+
+    Private(
+        EventQueue* queue,
+        std::mt19937* random,
+        const Config& config,
+        const Closed& closed);
+
+    EventQueue *const queue;
+    std::mt19937 *const random;
+    const Config config;
+    const Closed closed;
+
+    std::weak_ptr<Private> self;
+
+    std::unique_ptr<rtsp::Session> client;
+    std::unique_ptr<rtsp::ServerSession> server;
+
+    bool open = false;
+    EventQueue::TimePoint lastDelivery[2] = {};
+    unsigned messagesDelivered = 0;
+
+    rtsp::Session* session(Side side) const
+        { return side == ClientSide ? client.get() : server.get(); }
+
+    EventQueue::Duration transmitDelay();
+
+    void onConnected();
+
+    void transmit(Side to, std::string&& message);
+    void deliver(Side to, const std::string& message);
+
+    void close(CloseReason);
+};
+
+SimLink::Private::Private(
+    EventQueue* queue,
+    std::mt19937* random,
+    const Config& config,
+    const Closed& closed) :
+    queue(queue), random(random), config(config), closed(closed)
+{
+}
+
+EventQueue::Duration SimLink::Private::transmitDelay()
+{
+    if(config.jitter <= EventQueue::Duration::zero())
+        return config.latency;
+
+    std::uniform_int_distribution<EventQueue::Duration::rep> jitter(0, config.jitter.count());
+
+    return config.latency + EventQueue::Duration(jitter(*random));
+}
+
+void SimLink::Private::onConnected()
+{
+    if(!open)
+        return;
+
+    if(!server->onConnected()) {
+        close(CloseReason::Server);
+        return;
+    }
+
+    if(!client->onConnected()) {
+        close(CloseReason::Client);
+        return;
+    }
+}
+
+void SimLink::Private::transmit(Side to, std::string&& message)
+{
+    if(!open)
+        return;
+
+    if(config.disconnectProbability > 0) {
+        std::bernoulli_distribution drop(config.disconnectProbability);
+        if(drop(*random)) {
+            // message is lost together with connection
+            queue->schedule(
+                transmitDelay(),
+                [weakSelf = self] () {
+                    if(std::shared_ptr<Private> self = weakSelf.lock())
+                        self->close(CloseReason::Injected);
+                });
+            return;
+        }
+    }
+
+    EventQueue::TimePoint deliveryTime = queue->now() + transmitDelay();
+    if(!config.reorder) {
+        // WebSocket preserves message order
+        deliveryTime = std::max(deliveryTime, lastDelivery[to]);
+        lastDelivery[to] = deliveryTime;
+    }
+
+    queue->scheduleAt(
+        deliveryTime,
+        [weakSelf = self, to, message = std::move(message)] () {
+            if(std::shared_ptr<Private> self = weakSelf.lock())
+                self->deliver(to, message);
+        });
+}
+
+void SimLink::Private::deliver(Side to, const std::string& message)
+{
+    if(!open)
+        return;
+
+    ++messagesDelivered;
+
+    rtsp::Session* session = this->session(to);
+    const CloseReason closeReason = to == ClientSide ? CloseReason::Client : CloseReason::Server;
+
+    if(rtsp::IsRequest(message.data(), message.size())) {
+        std::unique_ptr<rtsp::Request> requestPtr =
+            std::make_unique<rtsp::Request>();
+        if(!rtsp::ParseRequest(message.data(), message.size(), requestPtr.get()) ||
+            !session->handleRequest(std::move(requestPtr)))
+        {
+            close(closeReason);
+        }
+    } else {
+        std::unique_ptr<rtsp::Response> responsePtr =
+            std::make_unique<rtsp::Response>();
+        if(!rtsp::ParseResponse(message.data(), message.size(), responsePtr.get()) ||
+            !session->handleResponse(std::move(responsePtr)))
+        {
+            close(closeReason);
+        }
+    }
+}
+
+void SimLink::Private::close(CloseReason reason)
+{
+    if(!open)
+        return;
+
+    open = false;
+
+    // sessions can be still on call stack, so destroy them on next iteration
+    queue->schedule(
+        EventQueue::Duration::zero(),
+        [weakSelf = self, reason] () {
+            std::shared_ptr<Private> self = weakSelf.lock();
+            if(!self)
+                return;
+
+            self->client.reset();
+            self->server.reset();
+
+            if(self->closed)
+                self->closed(reason);
+        });
+}
+
+
+SimLink::SimLink(
+    EventQueue* queue,
+    std::mt19937* random,
+    const Config& config,
+    const CreateServerSession& createServerSession,
+    const CreateClientSession& createClientSession,
+    const Closed& closed) noexcept :
+    _p(std::make_shared<Private>(queue, random, config, closed))
+{
+    _p->self = _p;
+
+    std::weak_ptr<Private> weakPrivate = _p;
+
+    auto sendRequest =
+        [weakPrivate] (Private::Side to, const rtsp::Request* request) {
+            std::shared_ptr<Private> p = weakPrivate.lock();
+            if(!p)
+                return;
+
+            const CloseReason reason =
+                to == Private::ServerSide ? CloseReason::Client : CloseReason::Server;
+            if(request)
+                p->transmit(to, rtsp::Serialize(*request));
+            else
+                p->close(reason);
+        };
+    auto sendResponse =
+        [weakPrivate] (Private::Side to, const rtsp::Response* response) {
+            std::shared_ptr<Private> p = weakPrivate.lock();
+            if(!p)
+                return;
+
+            const CloseReason reason =
+                to == Private::ServerSide ? CloseReason::Client : CloseReason::Server;
+            if(response)
+                p->transmit(to, rtsp::Serialize(*response));
+            else
+                p->close(reason);
+        };
+
+    _p->server =
+        createServerSession(
+            std::bind(sendRequest, Private::ClientSide, std::placeholders::_1),
+            std::bind(sendResponse, Private::ClientSide, std::placeholders::_1));
+    _p->client =
+        createClientSession(
+            std::bind(sendRequest, Private::ServerSide, std::placeholders::_1),
+            std::bind(sendResponse, Private::ServerSide, std::placeholders::_1));
+}
+
+SimLink::~SimLink()
+{
+}
+
+void SimLink::connect() noexcept
+{
+    if(_p->open || !_p->client || !_p->server)
+        return;
+
+    _p->open = true;
+
+    _p->queue->schedule(
+        _p->transmitDelay() + _p->transmitDelay(),
+        [weakPrivate = std::weak_ptr<Private>(_p)] () {
+            if(std::shared_ptr<Private> p = weakPrivate.lock())
+                p->onConnected();
+        });
+}
+
+void SimLink::disconnect() noexcept
+{
+    _p->close(CloseReason::Injected);
+}
+
+bool SimLink::isOpen() const noexcept
+{
+    return _p->open;
+}
+
+unsigned SimLink::messagesDelivered() const noexcept
+{
+    return _p->messagesDelivered;
+}
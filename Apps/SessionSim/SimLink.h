@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <random>
+
+#include "RtspSession/Session.h"
+#include "RtspSession/ServerSession.h"
+
+#include "EventQueue.h"
+
+
+// In-process replacement of WebSocket transport between client and server sessions.
+// Messages are serialized/parsed like on real connection
+// and delivered through EventQueue with configurable latency, jitter, reordering and drops.
+class SimLink
+{
+public:
+    struct Config
+    {
+        EventQueue::Duration latency = EventQueue::Duration::zero(); // one way
+        EventQueue::Duration jitter = EventQueue::Duration::zero();
+        bool reorder = false;
+        double disconnectProbability = 0; // per message
+    };
+
+    typedef std::function<
+        std::unique_ptr<rtsp::ServerSession> (
+            const rtsp::Session::SendRequest& sendRequest,
+            const rtsp::Session::SendResponse& sendResponse)> CreateServerSession;
+    typedef std::function<
+        std::unique_ptr<rtsp::Session> (
+            const rtsp::Session::SendRequest& sendRequest,
+            const rtsp::Session::SendResponse& sendResponse)> CreateClientSession;
+
+    enum class CloseReason {
+        Client,
+        Server,
+        Injected,
+    };
+    typedef std::function<void (CloseReason)> Closed;
+
+    SimLink(
+        EventQueue*,
+        std::mt19937* random,
+        const Config&,
+        const CreateServerSession&,
+        const CreateClientSession&,
+        const Closed&) noexcept;
+    ~SimLink();
+
+    // sessions are notified about connection after simulated handshake (one round trip)
+    void connect() noexcept;
+    // injects connection loss
+    void disconnect() noexcept;
+
+    bool isOpen() const noexcept;
+    unsigned messagesDelivered() const noexcept;
+
+private:
+    struct Private;
+    std::shared_ptr<Private> _p;
+};
@@ -7,6 +7,7 @@
 
 #include "TestParse.h"
 #include "TestSerialize.h"
+#include "TestTokenSigner.h"
 
 #include "Helpers/LwsLog.h"
 
@@ -111,6 +112,7 @@ int main(int argc, char *argv[])
 
     TestParse();
     TestSerialize();
+    TestTokenSigner();
 
     InitLwsLogger(spdlog::level::warn);
 
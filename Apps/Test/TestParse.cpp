@@ -189,4 +189,44 @@ void TestParse()
         assert(response.headerFields.size() == 2);
         assert(!response.body.empty());
     }
+
+    {
+        const char uriList[] =
+            "cam1\r\n"
+            "cam2/sub\r\n";
+        std::vector<std::string> uris;
+        const bool success = rtsp::ParseUriList(uriList, &uris);
+        assert(success);
+        assert(uris.size() == 2);
+        assert(uris[0] == "cam1");
+        assert(uris[1] == "cam2/sub");
+    }
+
+    {
+        const char mediaDescriptions[] =
+            "--webrtsp-part\r\n"
+            "Content-Location: cam1\r\n"
+            "Status: 200\r\n"
+            "Session: 1\r\n"
+            "Content-Type: application/sdp\r\n"
+            "\r\n"
+            "v=0\r\n"
+            "\r\n--webrtsp-part\r\n"
+            "Content-Location: cam2\r\n"
+            "Status: 404\r\n"
+            "\r\n"
+            "\r\n--webrtsp-part--\r\n";
+        rtsp::MediaDescriptions descriptions;
+        const bool success = rtsp::ParseMediaDescriptions(mediaDescriptions, &descriptions);
+        assert(success);
+        assert(descriptions.size() == 2);
+        assert(descriptions[0].uri == "cam1");
+        assert(descriptions[0].statusCode == 200);
+        assert(descriptions[0].session == "1");
+        assert(descriptions[0].sdp == "v=0\r\n");
+        assert(descriptions[1].uri == "cam2");
+        assert(descriptions[1].statusCode == 404);
+        assert(descriptions[1].session.empty());
+        assert(descriptions[1].sdp.empty());
+    }
 }
@@ -3,6 +3,7 @@
 #include <cassert>
 
 #include "RtspParser/RtspSerialize.h"
+#include "RtspParser/RtspParser.h"
 
 
 void TestSerialize() noexcept
@@ -33,4 +34,21 @@ void TestSerialize() noexcept
         "CSeq: 1\r\n"
         "Public: DESCRIBE, SETUP, TEARDOWN, PLAY, PAUSE\r\n");
 
+    const rtsp::MediaDescriptions descriptions = {
+        { "cam1", 200, "1", "v=0\r\n" },
+        { "cam2", 503, {}, {} },
+    };
+
+    std::string descriptionsBody;
+    rtsp::Serialize(descriptions, &descriptionsBody);
+
+    rtsp::MediaDescriptions parsedDescriptions;
+    const bool parsed = rtsp::ParseMediaDescriptions(descriptionsBody, &parsedDescriptions);
+    assert(parsed);
+    assert(parsedDescriptions.size() == 2);
+    assert(parsedDescriptions[0].uri == "cam1");
+    assert(parsedDescriptions[0].session == "1");
+    assert(parsedDescriptions[0].sdp == "v=0\r\n");
+    assert(parsedDescriptions[1].statusCode == 503);
+    assert(parsedDescriptions[1].sdp.empty());
 }
@@ -0,0 +1,124 @@
+#include "TestTokenSigner.h"
+
+#include <cassert>
+
+#include "Auth/TokenSigner.h"
+
+
+void TestTokenSigner() noexcept
+{
+    using Clock = auth::TokenSigner::Clock;
+
+    const auth::TokenSigner::Key key1 { "k1", "secret1" };
+    const auth::TokenSigner::Key key2 { "k2", "secret2" };
+
+    auth::TokenSigner signer({ key1 });
+
+    const Clock::time_point expiresAt = Clock::now() + std::chrono::hours(1);
+
+    {
+        const std::string token = signer.issue({ expiresAt, { "cam1", "cams/*" } });
+        assert(token.compare(0, 3, "k1.") == 0);
+
+        const std::optional<auth::TokenSigner::Claims> claims = signer.verify(token);
+        assert(claims);
+        assert(claims->expiresAt ==
+            std::chrono::time_point_cast<std::chrono::seconds>(expiresAt));
+        assert(claims->allowedUris.size() == 2);
+        assert(claims->allowedUris[0] == "cam1");
+        assert(claims->allowedUris[1] == "cams/*");
+
+        assert(signer.verify(token, "cam1"));
+        assert(!signer.verify(token, "cam2"));
+        assert(!signer.verify(token, "cam1/sub"));
+        assert(signer.verify(token, "cams/"));
+        assert(signer.verify(token, "cams/front"));
+        assert(!signer.verify(token, "cams"));
+        assert(!signer.verify(token, "camsfront"));
+        // session wide requests are allowed, LIST responses are filtered by server
+        assert(signer.verify(token, "*"));
+    }
+
+    {
+        // no uri claims - any uri allowed
+        const std::string token = signer.issue({ expiresAt, {} });
+        assert(signer.verify(token, "cam1"));
+        assert(signer.verify(token, "*"));
+    }
+
+    {
+        // tampered payload
+        const std::string token = signer.issue({ expiresAt, { "cam1" } });
+        const std::string::size_type payloadPos = token.find('.') + 1;
+        const std::string::size_type signaturePos = token.rfind('.') + 1;
+
+        const std::string widerToken = signer.issue({ expiresAt, {} });
+        const std::string widerPayload =
+            widerToken.substr(payloadPos, widerToken.rfind('.') - payloadPos);
+        const std::string forgedToken =
+            token.substr(0, payloadPos) + widerPayload + token.substr(signaturePos - 1);
+        assert(!signer.verify(forgedToken));
+
+        std::string tamperedToken = token;
+        tamperedToken[payloadPos] = tamperedToken[payloadPos] == 'A' ? 'B' : 'A';
+        assert(!signer.verify(tamperedToken));
+
+        // tampered signature
+        tamperedToken = token;
+        tamperedToken[signaturePos] = tamperedToken[signaturePos] == 'A' ? 'B' : 'A';
+        assert(!signer.verify(tamperedToken));
+
+        tamperedToken = token;
+        tamperedToken.pop_back();
+        assert(!signer.verify(tamperedToken));
+
+        assert(!signer.verify(token.substr(0, signaturePos - 1)));
+        assert(!signer.verify(std::string()));
+    }
+
+    {
+        // expired
+        const std::string token = signer.issue({ Clock::now() - std::chrono::seconds(1), {} });
+        assert(!signer.verify(token));
+        assert(!signer.verify(token, "cam1"));
+    }
+
+    {
+        // unknown key id
+        auth::TokenSigner otherSigner({ key2 });
+        const std::string token = otherSigner.issue({ expiresAt, {} });
+        assert(!signer.verify(token));
+
+        // same key id, different secret
+        auth::TokenSigner sameIdSigner({ { key1.id, "other secret" } });
+        assert(!signer.verify(sameIdSigner.issue({ expiresAt, {} })));
+    }
+
+    {
+        // key rotation
+        auth::TokenSigner rotatingSigner({ key1 });
+        const std::string oldToken = rotatingSigner.issue({ expiresAt, {} });
+
+        assert(!rotatingSigner.setKeys({}));
+        assert(!rotatingSigner.setKeys({ { "k.3", "secret3" } }));
+        assert(!rotatingSigner.setKeys({ { "k3", "" } }));
+        assert(rotatingSigner.verify(oldToken));
+
+        const bool keysSet = rotatingSigner.setKeys({ key2, key1 });
+        assert(keysSet);
+        (void)keysSet;
+
+        const std::string newToken = rotatingSigner.issue({ expiresAt, {} });
+        assert(newToken.compare(0, 3, "k2.") == 0);
+        assert(rotatingSigner.verify(oldToken));
+        assert(rotatingSigner.verify(newToken));
+        assert(!signer.verify(newToken));
+
+        const bool oldKeyDropped = rotatingSigner.setKeys({ key2 });
+        assert(oldKeyDropped);
+        (void)oldKeyDropped;
+
+        assert(!rotatingSigner.verify(oldToken));
+        assert(rotatingSigner.verify(newToken));
+    }
+}
@@ -0,0 +1,239 @@
+#include "TokenSigner.h"
+
+#include <cassert>
+#include <mutex>
+#include <shared_mutex>
+
+#include <glib.h>
+
+
+namespace auth {
+
+namespace {
+
+const char Separator = '.';
+const char ClaimsSeparator = '\n';
+const char *const WildcardUri = "*";
+
+std::string Base64UrlEncode(const void* data, size_t size)
+{
+    gchar* base64 = g_base64_encode(static_cast<const guchar*>(data), size);
+    std::string out = base64;
+    g_free(base64);
+
+    for(char& c: out) {
+        if(c == '+') c = '-';
+        else if(c == '/') c = '_';
+    }
+
+    const size_t paddingPos = out.find('=');
+    if(paddingPos != std::string::npos)
+        out.resize(paddingPos);
+
+    return out;
+}
+
+std::optional<std::string> Base64UrlDecode(const std::string& in)
+{
+    std::string base64;
+    base64.reserve(in.size() + 3);
+
+    // g_base64_decode silently skips invalid characters, so check them explicitly
+    for(char c: in) {
+        if(g_ascii_isalnum(c)) base64 += c;
+        else if(c == '-') base64 += '+';
+        else if(c == '_') base64 += '/';
+        else return {};
+    }
+
+    if(base64.size() % 4 == 1)
+        return {};
+
+    while(base64.size() % 4)
+        base64 += '=';
+
+    gsize size = 0;
+    guchar* data = g_base64_decode(base64.c_str(), &size);
+    std::string out(reinterpret_cast<const char*>(data), size);
+    g_free(data);
+
+    return out;
+}
+
+std::string Sign(const std::string& secret, const std::string& data)
+{
+    GHmac* hmac =
+        g_hmac_new(
+            G_CHECKSUM_SHA256,
+            reinterpret_cast<const guchar*>(secret.data()),
+            secret.size());
+    g_hmac_update(hmac, reinterpret_cast<const guchar*>(data.data()), data.size());
+
+    guint8 digest[32];
+    gsize digestSize = sizeof(digest);
+    g_hmac_get_digest(hmac, digest, &digestSize);
+    g_hmac_unref(hmac);
+
+    return Base64UrlEncode(digest, digestSize);
+}
+
+bool IsUriAllowed(const std::vector<std::string>& allowedUris, const std::string& uri)
+{
+    if(allowedUris.empty() || uri == WildcardUri)
+        return true;
+
+    for(const std::string& allowedUri: allowedUris) {
+        if(!allowedUri.empty() && allowedUri.back() == '*') {
+            if(uri.compare(0, allowedUri.size() - 1, allowedUri, 0, allowedUri.size() - 1) == 0)
+                return true;
+        } else if(uri == allowedUri) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
+
+bool ConstantTimeEquals(const std::string& l, const std::string& r) noexcept
+{
+    if(l.size() != r.size())
+        return false;
+
+    unsigned char diff = 0;
+    for(size_t i = 0; i < l.size(); ++i)
+        diff |= static_cast<unsigned char>(l[i] ^ r[i]);
+
+    return diff == 0;
+}
+
+
+struct TokenSigner::Private
+{
+    mutable std::shared_mutex mutex;
+    std::vector<Key> keys;
+};
+
+TokenSigner::TokenSigner(const std::vector<Key>& keys) noexcept :
+    _p(std::make_unique<Private>())
+{
+    const bool keysValid = setKeys(keys);
+    assert(keysValid);
+    (void)keysValid;
+}
+
+TokenSigner::~TokenSigner()
+{
+}
+
+bool TokenSigner::setKeys(const std::vector<Key>& keys) noexcept
+{
+    if(keys.empty())
+        return false;
+
+    for(const Key& key: keys) {
+        if(key.id.empty() || key.id.find(Separator) != std::string::npos || key.secret.empty())
+            return false;
+    }
+
+    std::unique_lock lock(_p->mutex);
+    _p->keys = keys;
+
+    return true;
+}
+
+std::string TokenSigner::issue(const Claims& claims) const noexcept
+{
+    std::string payload =
+        std::to_string(
+            std::chrono::duration_cast<std::chrono::seconds>(
+                claims.expiresAt.time_since_epoch()).count());
+    for(const std::string& uri: claims.allowedUris) {
+        payload += ClaimsSeparator;
+        payload += uri;
+    }
+
+    std::shared_lock lock(_p->mutex);
+
+    if(_p->keys.empty())
+        return std::string();
+
+    const Key& key = _p->keys.front();
+
+    std::string token = key.id;
+    token += Separator;
+    token += Base64UrlEncode(payload.data(), payload.size());
+
+    const std::string signature = Sign(key.secret, token);
+
+    token += Separator;
+    token += signature;
+
+    return token;
+}
+
+std::optional<TokenSigner::Claims> TokenSigner::verify(const std::string& token) const noexcept
+{
+    const size_t keyIdEnd = token.find(Separator);
+    if(keyIdEnd == std::string::npos)
+        return {};
+
+    const size_t payloadEnd = token.find(Separator, keyIdEnd + 1);
+    if(payloadEnd == std::string::npos)
+        return {};
+
+    const std::string keyId = token.substr(0, keyIdEnd);
+    const std::string signedPart = token.substr(0, payloadEnd);
+    const std::string signature = token.substr(payloadEnd + 1);
+
+    std::string expectedSignature;
+    {
+        std::shared_lock lock(_p->mutex);
+
+        for(const Key& key: _p->keys) {
+            if(key.id == keyId) {
+                expectedSignature = Sign(key.secret, signedPart);
+                break;
+            }
+        }
+    }
+
+    if(expectedSignature.empty() || !ConstantTimeEquals(signature, expectedSignature))
+        return {};
+
+    const std::optional<std::string> payload =
+        Base64UrlDecode(token.substr(keyIdEnd + 1, payloadEnd - keyIdEnd - 1));
+    if(!payload)
+        return {};
+
+    Claims claims;
+
+    size_t claimEnd = payload->find(ClaimsSeparator);
+    const std::string expiresAt = payload->substr(0, claimEnd);
+    gchar* expiresAtEnd = nullptr;
+    const gint64 expiresAtSeconds = g_ascii_strtoll(expiresAt.c_str(), &expiresAtEnd, 10);
+    if(expiresAt.empty() || *expiresAtEnd != '\0')
+        return {};
+
+    claims.expiresAt = Clock::time_point(std::chrono::seconds(expiresAtSeconds));
+    if(claims.expiresAt <= Clock::now())
+        return {};
+
+    while(claimEnd != std::string::npos) {
+        const size_t claimStart = claimEnd + 1;
+        claimEnd = payload->find(ClaimsSeparator, claimStart);
+        claims.allowedUris.emplace_back(payload->substr(claimStart, claimEnd - claimStart));
+    }
+
+    return claims;
+}
+
+bool TokenSigner::verify(const std::string& token, const std::string& uri) const noexcept
+{
+    const std::optional<Claims> claims = verify(token);
+
+    return claims && IsUriAllowed(claims->allowedUris, uri);
+}
+
+}
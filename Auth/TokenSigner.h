@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace auth {
+
+bool ConstantTimeEquals(const std::string&, const std::string&) noexcept;
+
+// Issues and verifies stateless auth tokens signed with HMAC-SHA256.
+// Token format: <key id>.<base64url payload>.<base64url signature>
+// Verification doesn't require any shared state except keys,
+// so tokens issued by one node are accepted by any other node with the same keys.
+// Thread safe.
+class TokenSigner
+{
+public:
+    typedef std::chrono::system_clock Clock;
+
+    struct Key
+    {
+        std::string id; // shouldn't contain '.'
+        std::string secret;
+    };
+
+    struct Claims
+    {
+        Clock::time_point expiresAt;
+        // empty - any uri allowed,
+        // trailing '*' allows any uri with such prefix
+        std::vector<std::string> allowedUris;
+    };
+
+    // first key is used for signing, all keys are accepted on verification
+    explicit TokenSigner(const std::vector<Key>& keys) noexcept;
+    ~TokenSigner();
+
+    // for key rotation: put new key first and keep previous one
+    // until all tokens signed with it expire
+    bool setKeys(const std::vector<Key>& keys) noexcept;
+
+    std::string issue(const Claims&) const noexcept;
+
+    std::optional<Claims> verify(const std::string& token) const noexcept;
+    // uri == rtsp::WildcardUri is allowed for any valid token,
+    // so responses to such requests (LIST) have to be filtered per uri by caller
+    bool verify(const std::string& token, const std::string& uri) const noexcept;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> _p;
+};
+
+}
@@ -0,0 +1,142 @@
+#include "TokenStore.h"
+
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+
+namespace auth {
+
+struct TokenStore::Shard
+{
+    typedef std::pair<Clock::time_point, std::string> Expiration;
+
+    struct Token
+    {
+        Clock::time_point expiresAt;
+        // kept until its heap entry is popped, so re-added token doesn't get second heap entry
+        bool removed = false;
+    };
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, Token> tokens;
+    size_t removedCount = 0;
+    // exactly one entry per entry in tokens, so heap doesn't grow on refresh or re-add.
+    // Entry of refreshed token is pushed back with actual expiration time on pop,
+    // entry of removed token is dropped on pop together with token
+    std::priority_queue<Expiration, std::vector<Expiration>, std::greater<Expiration>> expirations;
+
+    // should be called with exclusively locked mutex
+    void evictExpired(Clock::time_point now);
+};
+
+void TokenStore::Shard::evictExpired(Clock::time_point now)
+{
+    while(!expirations.empty() && expirations.top().first <= now) {
+        Expiration expiration = expirations.top();
+        expirations.pop();
+
+        auto it = tokens.find(expiration.second);
+        if(it == tokens.end())
+            continue;
+
+        Token& token = it->second;
+        if(token.removed) {
+            --removedCount;
+            tokens.erase(it);
+        } else if(token.expiresAt <= now) {
+            tokens.erase(it);
+        } else {
+            expiration.first = token.expiresAt;
+            expirations.emplace(std::move(expiration));
+        }
+    }
+}
+
+
+TokenStore::TokenStore(unsigned shards) noexcept :
+    _shardsCount(shards ? shards : 1),
+    _shards(new Shard[_shardsCount])
+{
+}
+
+TokenStore::~TokenStore()
+{
+}
+
+TokenStore::Shard& TokenStore::shard(const std::string& token) const noexcept
+{
+    return _shards[std::hash<std::string>()(token) % _shardsCount];
+}
+
+void TokenStore::add(const std::string& token, Clock::time_point expiresAt) noexcept
+{
+    Shard& shard = this->shard(token);
+
+    std::unique_lock lock(shard.mutex);
+
+    shard.evictExpired(Clock::now());
+
+    auto [it, inserted] = shard.tokens.try_emplace(token, Shard::Token { expiresAt });
+    if(inserted) {
+        shard.expirations.emplace(expiresAt, token);
+    } else {
+        // heap entry is still pending, it will be updated on pop
+        if(it->second.removed) {
+            it->second.removed = false;
+            --shard.removedCount;
+        }
+        it->second.expiresAt = expiresAt;
+    }
+}
+
+void TokenStore::remove(const std::string& token) noexcept
+{
+    Shard& shard = this->shard(token);
+
+    std::unique_lock lock(shard.mutex);
+
+    auto it = shard.tokens.find(token);
+    if(it != shard.tokens.end() && !it->second.removed) {
+        it->second.removed = true;
+        ++shard.removedCount;
+    }
+
+    shard.evictExpired(Clock::now());
+}
+
+bool TokenStore::isValid(const std::string& token) const noexcept
+{
+    const std::optional<Clock::time_point> expiresAt = this->expiresAt(token);
+
+    return expiresAt && *expiresAt > Clock::now();
+}
+
+std::optional<TokenStore::Clock::time_point>
+TokenStore::expiresAt(const std::string& token) const noexcept
+{
+    const Shard& shard = this->shard(token);
+
+    std::shared_lock lock(shard.mutex);
+
+    auto it = shard.tokens.find(token);
+    if(it == shard.tokens.end() || it->second.removed)
+        return {};
+
+    return it->second.expiresAt;
+}
+
+size_t TokenStore::size() const noexcept
+{
+    size_t size = 0;
+    for(unsigned i = 0; i < _shardsCount; ++i) {
+        std::shared_lock lock(_shards[i].mutex);
+        size += _shards[i].tokens.size() - _shards[i].removedCount;
+    }
+
+    return size;
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+
+
+namespace auth {
+
+// Thread safe storage of issued auth tokens.
+// Storage is split into independently locked shards,
+// expired tokens are evicted via per shard min-heap without full scans.
+class TokenStore
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum {
+        DEFAULT_SHARDS = 16,
+    };
+
+    explicit TokenStore(unsigned shards = DEFAULT_SHARDS) noexcept;
+    ~TokenStore();
+
+    // adds new token or extends expiration time of existing one
+    void add(const std::string& token, Clock::time_point expiresAt) noexcept;
+    void remove(const std::string& token) noexcept;
+
+    bool isValid(const std::string& token) const noexcept;
+    std::optional<Clock::time_point> expiresAt(const std::string& token) const noexcept;
+
+    size_t size() const noexcept;
+
+private:
+    struct Shard;
+
+    Shard& shard(const std::string& token) const noexcept;
+
+    const unsigned _shardsCount;
+    const std::unique_ptr<Shard[]> _shards;
+};
+
+}
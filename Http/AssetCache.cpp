@@ -0,0 +1,545 @@
+#include "AssetCache.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <glib-unix.h>
+#endif
+
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <CxxPtr/CPtr.h>
+#include <CxxPtr/GlibPtr.h>
+
+#include "Log.h"
+
+
+namespace http {
+
+namespace {
+
+const auto Log = HttpServerLog;
+
+enum {
+    STRCMP_EQUAL = 0,
+};
+
+const char *const GzipSuffix = ".gz";
+const char *const BrotliSuffix = ".br";
+
+std::optional<std::string> ReadFile(const std::string& path, size_t maxSize, struct stat* outStat = nullptr)
+{
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return {};
+
+    FDAutoClose fdAutoClose(fd);
+
+    struct stat fileStat = {};
+    if(fstat(fd, &fileStat) == -1 || !S_ISREG(fileStat.st_mode))
+        return {};
+
+    if(static_cast<size_t>(fileStat.st_size) > maxSize)
+        return {};
+
+    std::string content(fileStat.st_size, '\0');
+    size_t offset = 0;
+    while(offset < content.size()) {
+        const ssize_t readSize = read(fd, content.data() + offset, content.size() - offset);
+        if(readSize <= 0)
+            return {};
+        offset += readSize;
+    }
+
+    if(outStat)
+        *outStat = fileStat;
+
+    return content;
+}
+
+std::string HttpDate(time_t time)
+{
+    struct tm tm = {};
+    gmtime_r(&time, &tm);
+
+    char buffer[64];
+    const size_t size = strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+    return std::string(buffer, size);
+}
+
+std::string MakeETag(const std::string& content, const char* suffix = "")
+{
+    GCharPtr checksumPtr(g_compute_checksum_for_data(
+        G_CHECKSUM_SHA1,
+        reinterpret_cast<const guchar*>(content.data()),
+        content.size()));
+
+    return std::string("\"") + checksumPtr.get() + suffix + "\"";
+}
+
+std::string_view Trim(std::string_view token)
+{
+    while(!token.empty() && (token.front() == ' ' || token.front() == '\t'))
+        token.remove_prefix(1);
+    while(!token.empty() && (token.back() == ' ' || token.back() == '\t'))
+        token.remove_suffix(1);
+
+    return token;
+}
+
+// calls callback for every comma separated list item
+template<typename Callback>
+void ForEachListItem(std::string_view list, const Callback& callback)
+{
+    while(!list.empty()) {
+        const size_t commaPos = list.find(',');
+        callback(Trim(list.substr(0, commaPos)));
+        if(commaPos == std::string_view::npos)
+            break;
+        list.remove_prefix(commaPos + 1);
+    }
+}
+
+}
+
+const std::string& AssetCache::Asset::content(Encoding encoding) const
+{
+    switch(encoding) {
+    case Encoding::Identity:
+        break;
+    case Encoding::Gzip:
+        if(gzip)
+            return *gzip;
+        break;
+    case Encoding::Brotli:
+        if(brotli)
+            return *brotli;
+        break;
+    }
+
+    return identity;
+}
+
+const std::string& AssetCache::Asset::etag(Encoding encoding) const
+{
+    switch(encoding) {
+    case Encoding::Identity:
+        break;
+    case Encoding::Gzip:
+        if(gzip)
+            return gzipETag;
+        break;
+    case Encoding::Brotli:
+        if(brotli)
+            return brotliETag;
+        break;
+    }
+
+    return identityETag;
+}
+
+
+struct AssetCache::Private
+{
+    Private(
+        const std::string& rootPath,
+        size_t maxFileSize,
+        size_t maxSize,
+        GMainContext* context);
+    ~Private();
+
+    bool init();
+
+    bool watchDir(const std::string& dir);
+    void onInotify();
+    void invalidate(const std::string& fullPath);
+    void invalidateAll();
+
+    std::string relativePath(const std::string& fullPath) const;
+
+    const std::string rootPath;
+    const size_t maxFileSize;
+    const size_t maxSize;
+    GMainContext *const context;
+
+    int inotifyFd = -1;
+    GSourcePtr inotifySourcePtr;
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const Asset>> assets; // relative path -> asset
+    std::unordered_map<int, std::string> watchedDirs; // watch descriptor -> dir path
+    std::unordered_map<std::string, int> dirWatches;
+    size_t size = 0;
+    // incremented on every invalidation to detect races with concurrent loads
+    uint64_t generation = 0;
+};
+
+AssetCache::Private::Private(
+    const std::string& rootPath,
+    size_t maxFileSize,
+    size_t maxSize,
+    GMainContext* context) :
+    rootPath(rootPath),
+    maxFileSize(maxFileSize),
+    maxSize(maxSize),
+    context(context)
+{
+}
+
+AssetCache::Private::~Private()
+{
+    if(inotifySourcePtr)
+        g_source_destroy(inotifySourcePtr.get());
+
+    if(inotifyFd != -1)
+        close(inotifyFd);
+}
+
+bool AssetCache::Private::init()
+{
+#ifdef __linux__
+    assert(inotifyFd == -1);
+    if(inotifyFd != -1)
+        return false;
+
+    if(!maxFileSize || !maxSize)
+        return true;
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotifyFd == -1) {
+        Log()->error("inotify_init1 failed: {}. Asset cache disabled", strerror(errno));
+        return true;
+    }
+
+    inotifySourcePtr.reset(g_unix_fd_source_new(inotifyFd, G_IO_IN));
+    GSource* inotifySource = inotifySourcePtr.get();
+    g_source_set_callback(
+        inotifySource,
+        G_SOURCE_FUNC(+[] (gint, GIOCondition, gpointer userData) -> gboolean {
+            static_cast<Private*>(userData)->onInotify();
+            return G_SOURCE_CONTINUE;
+        }),
+        this,
+        nullptr);
+    g_source_attach(inotifySource, context);
+#endif
+
+    return true;
+}
+
+std::string AssetCache::Private::relativePath(const std::string& fullPath) const
+{
+    return fullPath.substr(rootPath.size());
+}
+
+// should be called with locked mutex
+bool AssetCache::Private::watchDir(const std::string& dir)
+{
+#ifdef __linux__
+    if(dirWatches.find(dir) != dirWatches.end())
+        return true;
+
+    const int wd =
+        inotify_add_watch(
+            inotifyFd,
+            dir.c_str(),
+            IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB |
+            IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+            IN_DELETE_SELF | IN_MOVE_SELF);
+    if(wd == -1) {
+        Log()->warn("Failed to watch \"{}\": {}", dir, strerror(errno));
+        return false;
+    }
+
+    watchedDirs.emplace(wd, dir);
+    dirWatches.emplace(dir, wd);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AssetCache::Private::onInotify()
+{
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[4096];
+
+    for(;;) {
+        const ssize_t size = read(inotifyFd, buffer, sizeof(buffer));
+        if(size <= 0)
+            break;
+
+        for(const char* ptr = buffer; ptr < buffer + size;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if(event->mask & IN_Q_OVERFLOW) {
+                invalidateAll();
+                continue;
+            }
+
+            std::string dir;
+            {
+                std::unique_lock lock(mutex);
+
+                auto it = watchedDirs.find(event->wd);
+                if(it == watchedDirs.end())
+                    continue;
+
+                dir = it->second;
+
+                if(event->mask & IN_IGNORED) {
+                    dirWatches.erase(dir);
+                    watchedDirs.erase(it);
+                }
+            }
+
+            if(event->len > 0)
+                invalidate(dir + G_DIR_SEPARATOR_S + event->name);
+            else
+                invalidateAll();
+        }
+    }
+#endif
+}
+
+void AssetCache::Private::invalidate(const std::string& fullPath)
+{
+    std::string path = fullPath;
+    if(g_str_has_suffix(path.c_str(), GzipSuffix))
+        path.resize(path.size() - strlen(GzipSuffix));
+    else if(g_str_has_suffix(path.c_str(), BrotliSuffix))
+        path.resize(path.size() - strlen(BrotliSuffix));
+
+    if(!g_str_has_prefix(path.c_str(), rootPath.c_str()))
+        return;
+
+    std::unique_lock lock(mutex);
+
+    ++generation;
+
+    auto it = assets.find(relativePath(path));
+    if(it == assets.end())
+        return;
+
+    const Asset& asset = *it->second;
+    size -= asset.identity.size();
+    if(asset.gzip) size -= asset.gzip->size();
+    if(asset.brotli) size -= asset.brotli->size();
+
+    Log()->debug("Asset \"{}\" invalidated", it->first);
+
+    assets.erase(it);
+}
+
+void AssetCache::Private::invalidateAll()
+{
+    std::unique_lock lock(mutex);
+
+    ++generation;
+    assets.clear();
+    size = 0;
+}
+
+
+AssetCache::AssetCache(
+    const std::string& rootPath,
+    size_t maxFileSize,
+    size_t maxSize,
+    GMainContext* context) noexcept :
+    _p(std::make_unique<Private>(rootPath, maxFileSize, maxSize, context))
+{
+}
+
+AssetCache::~AssetCache()
+{
+}
+
+bool AssetCache::init() noexcept
+{
+    return _p->init();
+}
+
+std::shared_ptr<const AssetCache::Asset> AssetCache::find(const std::string& path) const noexcept
+{
+    std::shared_lock lock(_p->mutex);
+
+    auto it = _p->assets.find(path);
+    if(it == _p->assets.end())
+        return nullptr;
+
+    return it->second;
+}
+
+std::shared_ptr<const AssetCache::Asset> AssetCache::load(const std::string& fullPath) noexcept
+{
+    if(_p->inotifyFd == -1)
+        return nullptr;
+
+    if(!g_str_has_prefix(fullPath.c_str(), _p->rootPath.c_str()))
+        return nullptr;
+
+    const std::string path = _p->relativePath(fullPath);
+
+    uint64_t generation;
+    {
+        std::unique_lock lock(_p->mutex);
+
+        auto it = _p->assets.find(path);
+        if(it != _p->assets.end())
+            return it->second;
+
+        if(_p->size >= _p->maxSize)
+            return nullptr;
+
+        // watch have to be added before file read to not miss modifications
+        GCharPtr dirPtr(g_path_get_dirname(fullPath.c_str()));
+        if(!_p->watchDir(dirPtr.get()))
+            return nullptr;
+
+        generation = _p->generation;
+    }
+
+    struct stat fileStat;
+    std::optional<std::string> content = ReadFile(fullPath, _p->maxFileSize, &fileStat);
+    if(!content)
+        return nullptr;
+
+    auto asset = std::make_shared<Asset>();
+    asset->contentType = ContentType(fullPath) ? ContentType(fullPath) : std::string();
+    asset->lastModified = HttpDate(fileStat.st_mtime);
+    asset->identityETag = MakeETag(*content);
+    asset->identity = std::move(*content);
+    asset->gzip = ReadFile(fullPath + GzipSuffix, _p->maxFileSize);
+    if(asset->gzip)
+        asset->gzipETag = MakeETag(*asset->gzip, "-gz");
+    asset->brotli = ReadFile(fullPath + BrotliSuffix, _p->maxFileSize);
+    if(asset->brotli)
+        asset->brotliETag = MakeETag(*asset->brotli, "-br");
+
+    const size_t assetSize =
+        asset->identity.size() +
+        (asset->gzip ? asset->gzip->size() : 0) +
+        (asset->brotli ? asset->brotli->size() : 0);
+
+    std::unique_lock lock(_p->mutex);
+
+    if(generation != _p->generation) {
+        // something was changed while file was read, so don't cache it this time
+        return asset;
+    }
+
+    if(_p->size + assetSize > _p->maxSize)
+        return asset;
+
+    auto [it, inserted] = _p->assets.emplace(path, asset);
+    if(!inserted)
+        return it->second;
+
+    _p->size += assetSize;
+
+    Log()->debug(
+        "Asset \"{}\" cached ({} bytes{}{})",
+        path,
+        asset->identity.size(),
+        asset->gzip ? ", gzip" : "",
+        asset->brotli ? ", brotli" : "");
+
+    return asset;
+}
+
+const char* AssetCache::ContentType(const std::string& path) noexcept
+{
+    static const std::pair<const char*, const char*> ContentTypes[] = {
+        { ".html", "text/html; charset=utf-8" },
+        { ".js", "text/javascript" },
+        { ".mjs", "text/javascript" },
+        { ".css", "text/css" },
+        { ".json", "application/json" },
+        { ".svg", "image/svg+xml" },
+        { ".png", "image/png" },
+        { ".ico", "image/x-icon" },
+        { ".wasm", "application/wasm" },
+    };
+
+    for(const auto& [suffix, contentType]: ContentTypes) {
+        if(g_str_has_suffix(path.c_str(), suffix))
+            return contentType;
+    }
+
+    return nullptr;
+}
+
+AssetCache::Encoding AssetCache::NegotiateEncoding(
+    const char* acceptEncoding,
+    const Asset& asset) noexcept
+{
+    if(!acceptEncoding)
+        return Encoding::Identity;
+
+    bool acceptGzip = false;
+    bool acceptBrotli = false;
+    ForEachListItem(acceptEncoding, [&] (std::string_view item) {
+        const size_t paramsPos = item.find(';');
+        const std::string_view coding = Trim(item.substr(0, paramsPos));
+        if(paramsPos != std::string_view::npos) {
+            const std::string_view params = Trim(item.substr(paramsPos + 1));
+            if(params.substr(0, 2) == "q=" &&
+                g_ascii_strtod(std::string(params.substr(2)).c_str(), nullptr) <= 0)
+            {
+                return; // explicitly rejected
+            }
+        }
+
+        if(coding == "gzip")
+            acceptGzip = true;
+        else if(coding == "br")
+            acceptBrotli = true;
+    });
+
+    if(acceptBrotli && asset.brotli)
+        return Encoding::Brotli;
+    if(acceptGzip && asset.gzip)
+        return Encoding::Gzip;
+
+    return Encoding::Identity;
+}
+
+bool AssetCache::IsNotModified(
+    const char* ifNoneMatch,
+    const char* ifModifiedSince,
+    const Asset& asset,
+    Encoding encoding) noexcept
+{
+    if(ifNoneMatch) {
+        const std::string& assetETag = asset.etag(encoding);
+        bool matched = false;
+        ForEachListItem(ifNoneMatch, [&] (std::string_view etag) {
+            // weak comparison is allowed for If-None-Match
+            if(etag.substr(0, 2) == "W/")
+                etag.remove_prefix(2);
+            if(etag == "*" || etag == assetETag)
+                matched = true;
+        });
+
+        // If-Modified-Since have to be ignored if If-None-Match is present
+        return matched;
+    }
+
+    if(ifModifiedSince)
+        return strcmp(ifModifiedSince, asset.lastModified.c_str()) == STRCMP_EQUAL;
+
+    return false;
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <glib.h>
+
+
+namespace http {
+
+// Keeps small static files (and their precompressed .gz/.br siblings) in memory.
+// Entries are invalidated on change via inotify, so it's enabled on Linux only.
+// Thread safe.
+class AssetCache
+{
+public:
+    enum class Encoding {
+        Identity,
+        Gzip,
+        Brotli,
+    };
+
+    struct Asset
+    {
+        std::string contentType;
+        std::string lastModified;
+
+        std::string identity;
+        std::optional<std::string> gzip;
+        std::optional<std::string> brotli;
+
+        // every content-coding has it's own strong validator
+        std::string identityETag;
+        std::string gzipETag;
+        std::string brotliETag;
+
+        const std::string& content(Encoding) const;
+        const std::string& etag(Encoding) const;
+    };
+
+    AssetCache(
+        const std::string& rootPath,
+        size_t maxFileSize,
+        size_t maxSize,
+        GMainContext* context) noexcept;
+    ~AssetCache();
+
+    bool init() noexcept;
+
+    // path relative to root, i.e. as it present in URL ("/index.html")
+    std::shared_ptr<const Asset> find(const std::string& path) const noexcept;
+    // fullPath should be already canonicalized and be inside root
+    // returns nullptr if file can't be cached (missing, too big, cache is full...)
+    std::shared_ptr<const Asset> load(const std::string& fullPath) noexcept;
+
+    static const char* ContentType(const std::string& path) noexcept;
+    static Encoding NegotiateEncoding(const char* acceptEncoding, const Asset&) noexcept;
+    // ifNoneMatch is compared with validator of negotiated encoding
+    static bool IsNotModified(
+        const char* ifNoneMatch,
+        const char* ifModifiedSince,
+        const Asset&,
+        Encoding) noexcept;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> _p;
+};
+
+}
@@ -25,7 +25,37 @@ struct Config
 
     std::optional<std::string> apiPrefix;
 
+    // Prometheus metrics, served without auth so better to keep bindToLoopbackOnly
+    std::optional<std::string> metricsPath;
+
+    // WebRTC endpoints, enabled by MicroServer::setCreateSession.
+    // playPrefix is WebRTSP specific server offer flow (see WebRTCEndpoints), not WHEP
+    std::optional<std::string> playPrefix;
+    std::optional<std::string> whipPrefix;
+    // ms to collect local ICE candidates to embed them into SDP sent to client.
+    // WHIP clients offering trickle ICE get SDP immediately
+    unsigned iceGatheringTime = 500;
+    // seconds without requests to established WebRTC endpoint resource before it's released, 0 - never.
+    // resources are released anyway when session tears down media (peer EOS, ICE failure)
+    unsigned resourceIdleTimeout = 0;
+
     std::map<std::string, bool> indexPaths; // path -> if auth required for path
+
+    // 0 - single internal polling thread
+    unsigned threadPoolSize = 0;
+    // 0 - libmicrohttpd default
+    unsigned connectionLimit = 0;
+    // 0 - unlimited
+    unsigned perIpConnectionLimit = 0;
+    // seconds of inactivity before connection is closed, 0 - never
+    unsigned connectionTimeout = 0;
+    // seconds async API request can take before "504 Gateway Timeout" is sent, 0 - never
+    unsigned asyncApiTimeout = 30;
+
+    // files bigger than this (or not fitting into cache) are served directly from disk
+    // 0 - disable in-memory asset cache
+    size_t assetCacheMaxFileSize = 256 * 1024;
+    size_t assetCacheMaxSize = 32 * 1024 * 1024;
 };
 
 }
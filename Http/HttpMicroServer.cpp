@@ -3,11 +3,20 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <vector>
+
 #include <microhttpd.h>
 
 #include <CxxPtr/CPtr.h>
 #include <CxxPtr/GlibPtr.h>
 
+#include "Metrics/Metrics.h"
+
+#include "AssetCache.h"
+#include "WebRTCEndpoints.h"
 #include "Log.h"
 
 
@@ -28,13 +37,12 @@ const char *const ConfigFile = "/Config.js";
 const char *const IndexFile = "/index.html";
 
 const char* AuthCookieName = "WebRTSP-Auth";
+const char *const BearerPrefix = "Bearer ";
 const char* AuthCookieStaticAttributes = "; HttpOnly; SameSite=Strict; Secure; Path=/";
 #ifdef NDEBUG
 const unsigned AuthCookieMaxAge = 30 * 24 * 60 * 60; // seconds
-const unsigned AuthCookieCleanupInterval = 15; // seconds
 #else
 const unsigned AuthCookieMaxAge = 5; // seconds
-const unsigned AuthCookieCleanupInterval = 1; // seconds
 #endif
 
 const MHD_DigestAuthAlgorithm DigestAlgorithm = MHD_DIGEST_ALG_MD5;
@@ -44,10 +52,80 @@ size_t NoUnescape(void*, struct MHD_Connection*, char* s) {
     return strlen(s);
 }
 
-struct UploadContext {
+struct AsyncApiCall
+{
+    AsyncApiCall(
+        MHD_Connection* connection,
+        bool addAuthCookie,
+        const char* authCookie) :
+        connection(connection),
+        addAuthCookie(addAuthCookie),
+        authCookie(authCookie ? std::optional<std::string>(authCookie) : std::nullopt) {}
+    ~AsyncApiCall()
+    {
+        if(response)
+            MHD_destroy_response(response);
+    }
+
+    MHD_Connection *const connection;
+    const bool addAuthCookie;
+    const std::optional<std::string> authCookie; // valid auth cookie to refresh
+
+    std::mutex mutex;
+    bool completed = false;
+    unsigned responseCode = 0;
+    MHD_Response* response = nullptr;
+    GSource* timeoutSource = nullptr;
+    GSource* workSource = nullptr; // destroyed on completion so work can't outlive server
+};
+
+struct RequestContext {
     std::string data;
+    std::shared_ptr<AsyncApiCall> asyncApiCall;
 };
 
+MHD_Response* CreateTextResponse(const std::string& text)
+{
+    return MHD_create_response_from_buffer(text.size(), (void*)text.c_str(), MHD_RESPMEM_PERSISTENT);
+}
+
+// resumes suspended connection, returns false if call was already completed
+bool CompleteAsyncApiCall(
+    const std::shared_ptr<AsyncApiCall>& call,
+    unsigned responseCode,
+    MHD_Response* response)
+{
+    {
+        std::lock_guard lock(call->mutex);
+
+        if(call->completed) {
+            if(response)
+                MHD_destroy_response(response);
+            return false;
+        }
+
+        call->completed = true;
+        call->responseCode = responseCode;
+        call->response = response;
+
+        if(call->timeoutSource) {
+            g_source_destroy(call->timeoutSource);
+            g_source_unref(call->timeoutSource);
+            call->timeoutSource = nullptr;
+        }
+
+        if(call->workSource) {
+            g_source_destroy(call->workSource);
+            g_source_unref(call->workSource);
+            call->workSource = nullptr;
+        }
+    }
+
+    MHD_resume_connection(call->connection);
+
+    return true;
+}
+
 }
 
 
@@ -57,12 +135,16 @@ struct MicroServer::Private
 {
     static const std::string AccessDeniedResponse;
     static const std::string NotFoundResponse;
+    static const std::string TimeoutResponse;
+    static const std::string ServiceUnavailableResponse;
     static const Config FixConfig(const Config&);
 
     Private(
         MicroServer*,
         const Config&,
         const std::string& configJsc,
+        const std::shared_ptr<auth::TokenStore>&,
+        const std::shared_ptr<const auth::TokenSigner>&,
         const MicroServer::OnNewAuthToken&,
         const MicroServer::APIRequestHandler&,
         GMainContext* context);
@@ -78,6 +160,18 @@ struct MicroServer::Private
         const char* uploadData,
         size_t* uploadDataSize,
         void ** conCls);
+    void onRequestCompleted(void** conCls);
+
+    // call will be executed on GMainContext thread
+    MHD_Result startAsyncApiCall(
+        MHD_Connection* connection,
+        RequestContext* requestContext,
+        bool addAuthCookie,
+        const char* authCookie,
+        std::function<void (const MicroServer::APIResponder&)>&& call);
+    MHD_Result queueAsyncApiResponse(
+        MHD_Connection* connection,
+        const std::shared_ptr<AsyncApiCall>&);
 
     bool isValidCookie(const char* cookie);
     void addCookie(MHD_Response*);
@@ -89,11 +183,15 @@ struct MicroServer::Private
         bool expireCookie,
         bool isStale) const;
     MHD_Result queueNotFoundResponse(MHD_Connection* connection) const;
+    MHD_Result queueMetricsResponse(MHD_Connection* connection) const;
+
+    std::pair<unsigned, MHD_Response*> createAssetResponse(
+        MHD_Connection* connection,
+        const std::shared_ptr<const AssetCache::Asset>&) const;
 
     void postToken(
         const std::string& token,
         std::chrono::steady_clock::time_point expiresAt) const;
-    void cleanupCookies();
 
     MicroServer *const owner;
 
@@ -102,17 +200,24 @@ struct MicroServer::Private
     const std::string configJsPath;
     MHD_Daemon* daemon = nullptr;
     std::vector<uint8_t> configJsBuffer;
+    const std::shared_ptr<auth::TokenStore> tokenStore;
+    const std::shared_ptr<const auth::TokenSigner> tokenSigner;
     const MicroServer::OnNewAuthToken onNewAuthTokenCallback;
     const MicroServer::APIRequestHandler apiRequestHandler;
+    MicroServer::AsyncAPIRequestHandler asyncApiRequestHandler;
+    std::unique_ptr<WebRTCEndpoints> webRTCEndpoints;
     GMainContext* context;
 
-    std::unordered_map<std::string, const MicroServer::AuthCookieData> authCookies;
-    std::chrono::steady_clock::time_point nextAuthCookiesCleanupTime =
-        std::chrono::steady_clock::time_point::min();
+    std::mutex asyncApiCallsMutex;
+    std::set<std::shared_ptr<AsyncApiCall>> asyncApiCalls; // with suspended connections
+
+    AssetCache assetCache;
 };
 
 const std::string MicroServer::Private::AccessDeniedResponse = "Access denied";
 const std::string MicroServer::Private::NotFoundResponse = "Not found";
+const std::string MicroServer::Private::TimeoutResponse = "Timeout";
+const std::string MicroServer::Private::ServiceUnavailableResponse = "Service unavailable";
 
 const Config MicroServer::Private::FixConfig(const Config& config)
 {
@@ -122,14 +227,22 @@ const Config MicroServer::Private::FixConfig(const Config& config)
         tmpConfig.indexPaths.emplace("/", !config.passwd.empty());
     }
 
-    if(tmpConfig.apiPrefix) {
-        const std::string& apiPrefix = tmpConfig.apiPrefix.value();
+    auto fixPrefix = [] (std::optional<std::string>* prefix, const char* name) {
+        if(!*prefix)
+            return;
 
-        if(apiPrefix.empty() || apiPrefix.size() < 2 || *apiPrefix.cbegin() != '/' || *apiPrefix.crbegin() == '/') {
-            Log()->warn("Invalid apiPrefix. Ignoring...");
-            tmpConfig.apiPrefix.reset();
+        const std::string& value = prefix->value();
+
+        if(value.empty() || value.size() < 2 || *value.cbegin() != '/' || *value.crbegin() == '/') {
+            Log()->warn("Invalid {}. Ignoring...", name);
+            prefix->reset();
         }
-    }
+    };
+
+    fixPrefix(&tmpConfig.apiPrefix, "apiPrefix");
+    fixPrefix(&tmpConfig.metricsPath, "metricsPath");
+    fixPrefix(&tmpConfig.playPrefix, "playPrefix");
+    fixPrefix(&tmpConfig.whipPrefix, "whipPrefix");
 
     return tmpConfig;
 }
@@ -138,6 +251,8 @@ MicroServer::Private::Private(
     MicroServer* owner,
     const Config& config,
     const std::string& configJs,
+    const std::shared_ptr<auth::TokenStore>& tokenStore,
+    const std::shared_ptr<const auth::TokenSigner>& tokenSigner,
     const OnNewAuthToken& onNewAuthTokenCallback,
     const APIRequestHandler& apiRequestHandler,
     GMainContext* context) :
@@ -146,9 +261,16 @@ MicroServer::Private::Private(
     wwwRootPath(GCharPtr(g_canonicalize_filename(config.wwwRoot.c_str(), nullptr)).get()),
     configJsPath(GCharPtr(g_build_filename(wwwRootPath.c_str(), ConfigFile, nullptr)).get()),
     configJsBuffer(configJs.begin(), configJs.end()),
+    tokenStore(tokenStore ? tokenStore : std::make_shared<auth::TokenStore>()),
+    tokenSigner(tokenSigner),
     onNewAuthTokenCallback(onNewAuthTokenCallback),
     apiRequestHandler(apiRequestHandler),
-    context(context)
+    context(context),
+    assetCache(
+        wwwRootPath,
+        this->config.assetCacheMaxFileSize,
+        this->config.assetCacheMaxSize,
+        context)
 {
 }
 
@@ -170,19 +292,56 @@ bool MicroServer::Private::init()
         Private* p =static_cast<Private*>(cls);
         return p->httpCallback(connection, url, method, version, uploadData, uploadDataSize, conCls);
     };
+    auto completedCallback = [] (
+        void* cls,
+        struct MHD_Connection*,
+        void** conCls,
+        MHD_RequestTerminationCode)
+    {
+        Private* p =static_cast<Private*>(cls);
+        p->onRequestCompleted(conCls);
+    };
 
-    Log()->info("Starting HTTP server on port {} in \"{}\"", config.port, wwwRootPath);
+    if(!assetCache.init())
+        return false;
 
+    Log()->info(
+        "Starting HTTP server on port {} in \"{}\" with {} worker thread(s)",
+        config.port,
+        wwwRootPath,
+        std::max(config.threadPoolSize, 1u));
+
+    std::vector<MHD_OptionItem> options = {
+        { MHD_OPTION_NONCE_NC_SIZE, 1000, nullptr },
+        { MHD_OPTION_UNESCAPE_CALLBACK, reinterpret_cast<intptr_t>(&NoUnescape), nullptr },
+        {
+            MHD_OPTION_NOTIFY_COMPLETED,
+            reinterpret_cast<intptr_t>(static_cast<MHD_RequestCompletedCallback>(completedCallback)),
+            this
+        },
+    };
+    if(config.threadPoolSize > 1)
+        options.push_back({ MHD_OPTION_THREAD_POOL_SIZE, config.threadPoolSize, nullptr });
+    if(config.connectionLimit)
+        options.push_back({ MHD_OPTION_CONNECTION_LIMIT, config.connectionLimit, nullptr });
+    if(config.perIpConnectionLimit)
+        options.push_back({ MHD_OPTION_PER_IP_CONNECTION_LIMIT, config.perIpConnectionLimit, nullptr });
+    if(config.connectionTimeout)
+        options.push_back({ MHD_OPTION_CONNECTION_TIMEOUT, config.connectionTimeout, nullptr });
+    options.push_back({ MHD_OPTION_END, 0, nullptr });
+
+    unsigned flags = MHD_USE_AUTO | MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_ERROR_LOG;
+    if(asyncApiRequestHandler || webRTCEndpoints)
+        flags |= MHD_ALLOW_SUSPEND_RESUME;
+
+    // MHD_USE_AUTO selects epoll where available
     daemon =
         MHD_start_daemon(
-            MHD_USE_AUTO | MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_ERROR_LOG,
+            flags,
             config.port,
             nullptr, nullptr,
             callback, this,
-            MHD_OPTION_NONCE_NC_SIZE, 1000,
-            MHD_OPTION_UNESCAPE_CALLBACK,
-            NoUnescape,
-            nullptr,
+            MHD_OPTION_ARRAY, options.data(),
             MHD_OPTION_END);
 
     return daemon != nullptr;
@@ -190,17 +349,143 @@ bool MicroServer::Private::init()
 
 MicroServer::Private::~Private()
 {
+    // MHD_stop_daemon requires all connections to be resumed
+    std::vector<std::shared_ptr<AsyncApiCall>> pendingCalls;
+    {
+        std::lock_guard lock(asyncApiCallsMutex);
+        pendingCalls.assign(asyncApiCalls.begin(), asyncApiCalls.end());
+    }
+    for(const std::shared_ptr<AsyncApiCall>& call: pendingCalls) {
+        CompleteAsyncApiCall(
+            call,
+            MHD_HTTP_SERVICE_UNAVAILABLE,
+            CreateTextResponse(ServiceUnavailableResponse));
+    }
+
     MHD_stop_daemon(daemon);
 }
 
+void MicroServer::Private::onRequestCompleted(void** conCls)
+{
+    std::unique_ptr<RequestContext> requestContext(static_cast<RequestContext*>(*conCls));
+    *conCls = nullptr;
+
+    if(requestContext && requestContext->asyncApiCall) {
+        std::lock_guard lock(asyncApiCallsMutex);
+        asyncApiCalls.erase(requestContext->asyncApiCall);
+    }
+}
+
+// running on worker thread!
+MHD_Result MicroServer::Private::startAsyncApiCall(
+    MHD_Connection* connection,
+    RequestContext* requestContext,
+    bool addAuthCookie,
+    const char* authCookie,
+    std::function<void (const MicroServer::APIResponder&)>&& work)
+{
+    auto call = std::make_shared<AsyncApiCall>(connection, addAuthCookie, authCookie);
+    requestContext->asyncApiCall = call;
+
+    MHD_suspend_connection(connection);
+
+    if(config.asyncApiTimeout) {
+        GSourcePtr timeoutSourcePtr(g_timeout_source_new_seconds(config.asyncApiTimeout));
+        GSource* timeoutSource = timeoutSourcePtr.get();
+        g_source_set_callback(
+            timeoutSource,
+            [] (gpointer userData) -> gboolean {
+                const std::shared_ptr<AsyncApiCall>& call =
+                    *reinterpret_cast<std::shared_ptr<AsyncApiCall>*>(userData);
+
+                Log()->warn("API request timeout");
+
+                CompleteAsyncApiCall(
+                    call,
+                    MHD_HTTP_GATEWAY_TIMEOUT,
+                    CreateTextResponse(TimeoutResponse));
+
+                return G_SOURCE_REMOVE;
+            },
+            new std::shared_ptr<AsyncApiCall>(call),
+            [] (gpointer userData) {
+                delete reinterpret_cast<std::shared_ptr<AsyncApiCall>*>(userData);
+            });
+        call->timeoutSource = g_source_ref(timeoutSource);
+        g_source_attach(timeoutSource, context);
+    }
+
+    {
+        std::lock_guard lock(asyncApiCallsMutex);
+        asyncApiCalls.insert(call);
+    }
+
+    GSourcePtr idleSourcePtr(g_idle_source_new());
+    GSource* idleSource = idleSourcePtr.get();
+
+    struct CallbackData {
+        const std::function<void (const MicroServer::APIResponder&)> work;
+        const std::shared_ptr<AsyncApiCall> call;
+    };
+    CallbackData* callbackData = new CallbackData { std::move(work), call };
+    g_source_set_callback(
+        idleSource,
+        [] (gpointer userData) -> gboolean {
+            const CallbackData* callbackData = reinterpret_cast<CallbackData*>(userData);
+
+            callbackData->work(
+                [call = callbackData->call] (unsigned responseCode, MHD_Response* response) {
+                    CompleteAsyncApiCall(call, responseCode, response);
+                });
+
+            return G_SOURCE_REMOVE;
+        },
+        callbackData,
+        [] (gpointer userData) {
+            delete reinterpret_cast<CallbackData*>(userData);
+        });
+    {
+        std::lock_guard lock(call->mutex);
+        if(!call->completed) {
+            call->workSource = g_source_ref(idleSource);
+            g_source_attach(idleSource, context);
+        }
+    }
+
+    return MHD_YES;
+}
+
+// running on worker thread!
+MHD_Result MicroServer::Private::queueAsyncApiResponse(
+    MHD_Connection* connection,
+    const std::shared_ptr<AsyncApiCall>& call)
+{
+    unsigned responseCode;
+    g_autoptr(MHD_Response) response = nullptr;
+    {
+        std::lock_guard lock(call->mutex);
+        responseCode = call->responseCode;
+        response = std::exchange(call->response, nullptr);
+    }
+
+    if(!responseCode || !response)
+        return MHD_NO;
+
+    if(call->addAuthCookie) {
+        addCookie(response);
+    } else if(call->authCookie) {
+        refreshCookie(response, *call->authCookie);
+    }
+
+    return MHD_queue_response(connection, responseCode, response);
+}
+
 void MicroServer::Private::postToken(
     const std::string& token,
     std::chrono::steady_clock::time_point expiresAt) const
 {
-    if(!onNewAuthTokenCallback) {
-        Log()->warn("Auth token callback is missing");
+    if(!onNewAuthTokenCallback)
         return;
-    }
 
     GSourcePtr idleSourcePtr(g_idle_source_new());
     GSource* idleSource = idleSourcePtr.get();
@@ -234,15 +519,8 @@ bool MicroServer::Private::isValidCookie(const char* inCookie)
     if(!inCookie)
         return false;
 
-    auto it = authCookies.find(inCookie);
-    if(it == authCookies.end())
-        return false;
-
-    const AuthCookieData& cookieData = it->second;
-    if(cookieData.expiresAt < std::chrono::steady_clock::now()) {
-        authCookies.erase(it);
+    if(tokenSigner ? !tokenSigner->verify(inCookie) : !tokenStore->isValid(inCookie))
         return false;
-    }
 
      // FIXME! add check of source IP address
 
@@ -251,8 +529,15 @@ bool MicroServer::Private::isValidCookie(const char* inCookie)
 
 void MicroServer::Private::addCookie(MHD_Response* response)
 {
-    GCharPtr randomPtr(g_uuid_string_random()); // FIXME! use something more sequre
-    const std::string random = randomPtr.get();
+    std::string random;
+    if(tokenSigner) {
+        random = tokenSigner->issue({
+            std::chrono::system_clock::now() + std::chrono::seconds(AuthCookieMaxAge),
+            {} });
+    } else {
+        GCharPtr randomPtr(g_uuid_string_random()); // FIXME! use something more sequre
+        random = randomPtr.get();
+    }
 
     std::string cookie = AuthCookieName;
     cookie += "=" + random;
@@ -264,7 +549,8 @@ void MicroServer::Private::addCookie(MHD_Response* response)
 
     const std::chrono::steady_clock::time_point expiresAt =
         std::chrono::steady_clock::now() + std::chrono::seconds(AuthCookieMaxAge);
-    authCookies.emplace(random, AuthCookieData { expiresAt });
+    if(!tokenSigner)
+        tokenStore->add(random, expiresAt);
 
     postToken(random, expiresAt);
 
@@ -275,6 +561,12 @@ void MicroServer::Private::refreshCookie(MHD_Response* response, const std::stri
 {
     Log()->debug("Refreshing auth cookie \"{}\"...", inCookie);
 
+    if(tokenSigner) {
+        // signed token expiration can't be prolonged, so just issue new one
+        addCookie(response);
+        return;
+    }
+
     std::string cookie = AuthCookieName;
     cookie += "=" + inCookie;
     cookie += "; Max-Age=";
@@ -285,7 +577,7 @@ void MicroServer::Private::refreshCookie(MHD_Response* response, const std::stri
 
     const std::chrono::steady_clock::time_point expiresAt =
         std::chrono::steady_clock::now() + std::chrono::seconds(AuthCookieMaxAge);
-    authCookies.emplace(inCookie, AuthCookieData { expiresAt });
+    tokenStore->add(inCookie, expiresAt);
 
     postToken(inCookie, expiresAt);
 }
@@ -307,6 +599,13 @@ MHD_Result MicroServer::Private::queueAccessDeniedResponse(
     bool expireCookie,
     bool isStale) const
 {
+    static metrics::Counter& authFailures =
+        metrics::Registry::Default().counter(
+            "webrtsp_auth_failures_total",
+            "Rejected authorization attempts",
+            { { "source", "http" } });
+    authFailures.inc();
+
     MHD_Response* response =
         MHD_create_response_from_buffer(
             AccessDeniedResponse.size(),
@@ -339,20 +638,84 @@ MHD_Result MicroServer::Private::queueNotFoundResponse(MHD_Connection* connectio
     return queueResult;
 }
 
-void MicroServer::Private::cleanupCookies()
+// running on worker thread!
+MHD_Result MicroServer::Private::queueMetricsResponse(MHD_Connection* connection) const
 {
-    const auto now = std::chrono::steady_clock::now();
-    if(nextAuthCookiesCleanupTime > now)
-        return;
+    const std::string body = metrics::Registry::Default().serialize();
 
-    for(auto it = authCookies.begin(); it != authCookies.end();) {
-        if(it->second.expiresAt < now)
-            it = authCookies.erase(it);
-        else
-            ++it;
+    MHD_Response* response =
+        MHD_create_response_from_buffer(
+            body.size(),
+            (void*)body.data(),
+            MHD_RESPMEM_MUST_COPY);
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, metrics::PrometheusContentType);
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CACHE_CONTROL, "no-store");
+    MHD_Result queueResult = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+
+    return queueResult;
+}
+
+// running on worker thread!
+std::pair<unsigned, MHD_Response*> MicroServer::Private::createAssetResponse(
+    MHD_Connection* connection,
+    const std::shared_ptr<const AssetCache::Asset>& asset) const
+{
+    MHD_Response* response;
+    unsigned responseCode;
+
+    const AssetCache::Encoding encoding =
+        AssetCache::NegotiateEncoding(
+            MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_ACCEPT_ENCODING),
+            *asset);
+
+    const bool notModified =
+        AssetCache::IsNotModified(
+            MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH),
+            MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_MODIFIED_SINCE),
+            *asset,
+            encoding);
+    if(notModified) {
+        response = MHD_create_response_from_buffer(0, nullptr, MHD_RESPMEM_PERSISTENT);
+        responseCode = MHD_HTTP_NOT_MODIFIED;
+    } else {
+        const std::string& content = asset->content(encoding);
+
+        // asset can be invalidated while response is still in progress
+        auto* assetRef = new std::shared_ptr<const AssetCache::Asset>(asset);
+        response =
+            MHD_create_response_from_buffer_with_free_callback_cls(
+                content.size(),
+                content.data(),
+                [] (void* cls) {
+                    delete static_cast<std::shared_ptr<const AssetCache::Asset>*>(cls);
+                },
+                assetRef);
+        responseCode = MHD_HTTP_OK;
+
+        switch(encoding) {
+        case AssetCache::Encoding::Identity:
+            break;
+        case AssetCache::Encoding::Gzip:
+            MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_ENCODING, "gzip");
+            break;
+        case AssetCache::Encoding::Brotli:
+            MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_ENCODING, "br");
+            break;
+        }
+
+        if(!asset->contentType.empty())
+            MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, asset->contentType.c_str());
     }
 
-    nextAuthCookiesCleanupTime = now + std::chrono::seconds(AuthCookieCleanupInterval);
+    MHD_add_response_header(response, MHD_HTTP_HEADER_ETAG, asset->etag(encoding).c_str());
+    MHD_add_response_header(response, MHD_HTTP_HEADER_LAST_MODIFIED, asset->lastModified.c_str());
+    // allow to store but force revalidation since file names are not versioned
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CACHE_CONTROL, "no-cache");
+    if(asset->gzip || asset->brotli)
+        MHD_add_response_header(response, MHD_HTTP_HEADER_VARY, MHD_HTTP_HEADER_ACCEPT_ENCODING);
+
+    return { responseCode, response };
 }
 
 // running on worker thread!
@@ -397,50 +760,54 @@ MHD_Result MicroServer::Private::httpCallback(
                 Log()->error("Too big {} body declared for \"{}\"", methodString, url);
                 return MHD_NO;
             }
-
-            *conCls = new UploadContext();
-        } else {
-            *conCls = GINT_TO_POINTER(TRUE);
         }
 
+        *conCls = new RequestContext();
+
         return MHD_YES;
     }
 
-    std::unique_ptr<UploadContext> uploadContext;
+    RequestContext* requestContext = static_cast<RequestContext*>(*conCls);
+
+    if(requestContext->asyncApiCall) {
+        // connection was resumed after async API call completion
+        return queueAsyncApiResponse(connection, requestContext->asyncApiCall);
+    }
+
     std::string_view body;
     if(method == Method::POST || method == Method::PATCH) {
-        uploadContext.reset(reinterpret_cast<UploadContext*>(*conCls));
-
-        if(uploadContext->data.size() + *uploadDataSize > MAX_UPLOAD_SIZE) {
+        if(requestContext->data.size() + *uploadDataSize > MAX_UPLOAD_SIZE) {
             Log()->error("Too big {} body for \"{}\"", methodString, url);
             return MHD_NO;
         }
 
         if(*uploadDataSize) {
-            uploadContext.release()->data.append(uploadData, *uploadDataSize);
+            requestContext->data.append(uploadData, *uploadDataSize);
             *uploadDataSize = 0;
             return MHD_YES;
         }
 
-        body = uploadContext->data;
+        body = requestContext->data;
     } else {
         body = std::string_view(uploadData, *uploadDataSize);
     }
 
     Log()->debug("Serving {} request for \"{}\"...", methodString, url);
 
+    if(method == Method::GET && config.metricsPath && config.metricsPath.value() == url)
+        return queueMetricsResponse(connection);
+
     const bool isApiPath = config.apiPrefix ?
         g_str_has_prefix(url, config.apiPrefix.value().c_str()) :
         false;
-    auto it = !isApiPath ? config.indexPaths.find(url) : config.indexPaths.end();
+    const bool isWebRTCPath = !isApiPath && webRTCEndpoints && webRTCEndpoints->isEndpointPath(url);
+    auto it = !isApiPath && !isWebRTCPath ? config.indexPaths.find(url) : config.indexPaths.end();
     const bool isIndexPath = it != config.indexPaths.end();
     const bool pathAuthRequired = isIndexPath ? it->second : false;
 
-    if(!isApiPath && method != Method::GET)
+    if(!isApiPath && !isWebRTCPath && method != Method::GET)
       return MHD_NO;
 
-    cleanupCookies();
-
     bool addAuthCookie = false;
 
     const char* inAuthCookie= MHD_lookup_connection_value(connection, MHD_COOKIE_KIND, AuthCookieName);
@@ -488,8 +855,55 @@ MHD_Result MicroServer::Private::httpCallback(
         }
     }
 
+    if(isApiPath && asyncApiRequestHandler) {
+        return startAsyncApiCall(
+            connection,
+            requestContext,
+            addAuthCookie,
+            authCookieValid ? inAuthCookie : nullptr,
+            [handler = asyncApiRequestHandler, method, uri = std::string(url), body = std::string(body)] (
+                const MicroServer::APIResponder& responder)
+            {
+                handler(method, uri, body, responder);
+            });
+    }
+
+    if(isWebRTCPath) {
+        WebRTCEndpoints::Request request;
+        request.method = method;
+        request.path = url;
+        if(const char* contentType = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_CONTENT_TYPE))
+            request.contentType = contentType;
+        const char* authorization =
+            MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_AUTHORIZATION);
+        if(authorization && g_str_has_prefix(authorization, BearerPrefix))
+            request.authToken = authorization + strlen(BearerPrefix);
+        if(authCookieValid)
+            request.authCookie = inAuthCookie;
+        request.body = body;
+
+        return startAsyncApiCall(
+            connection,
+            requestContext,
+            addAuthCookie,
+            authCookieValid ? inAuthCookie : nullptr,
+            [endpoints = webRTCEndpoints.get(), request = std::move(request)] (
+                const MicroServer::APIResponder& responder)
+            {
+                endpoints->handleRequest(request, responder);
+            });
+    }
+
+    // cache is keyed by canonical paths only, so hit on raw url is safe
+    const char *const assetPath = isIndexPath ? IndexFile : url;
+    std::shared_ptr<const AssetCache::Asset> asset;
+    if(!isApiPath && strcmp(assetPath, ConfigFile) != STRCMP_EQUAL)
+        asset = assetCache.find(assetPath);
+
     GCharPtr safePathPtr;
-    if(isIndexPath) {
+    if(asset) {
+        // no file system lookup required
+    } else if(isIndexPath) {
         Log()->debug("Routing \"{}\" to \"{}\"...", url, IndexFile);
         safePathPtr.reset(g_build_filename(wwwRootPath.c_str(), IndexFile, nullptr));
     } else {
@@ -505,6 +919,8 @@ MHD_Result MicroServer::Private::httpCallback(
     unsigned responseCode = 0;
     if(isApiPath) {
         std::tie(responseCode, response) = apiRequestHandler(method, url, body);
+    } else if(asset) {
+        std::tie(responseCode, response) = createAssetResponse(connection, asset);
     } else if(configJsPath == safePathPtr.get()) {
         response =
             MHD_create_response_from_buffer(
@@ -513,6 +929,8 @@ MHD_Result MicroServer::Private::httpCallback(
                 MHD_RESPMEM_PERSISTENT);
         responseCode = MHD_HTTP_OK;
         MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, "text/javascript");
+    } else if((asset = assetCache.load(safePathPtr.get()))) {
+        std::tie(responseCode, response) = createAssetResponse(connection, asset);
     } else {
         const int fd = open(safePathPtr.get(), O_RDONLY);
         FDAutoClose fdAutoClose(fd);
@@ -556,16 +974,69 @@ MicroServer::MicroServer(
         this,
         config,
         configJs,
+        nullptr,
+        nullptr,
         onNewAuthTokenCallback,
         apiRequestHandler,
         context))
 {
 }
 
+MicroServer::MicroServer(
+    const Config& config,
+    const std::string& configJs,
+    const std::shared_ptr<auth::TokenStore>& tokenStore,
+    const APIRequestHandler& apiRequestHandler,
+    GMainContext* context) noexcept :
+    _p(std::make_unique<Private>(
+        this,
+        config,
+        configJs,
+        tokenStore,
+        nullptr,
+        OnNewAuthToken(),
+        apiRequestHandler,
+        context))
+{
+}
+
+MicroServer::MicroServer(
+    const Config& config,
+    const std::string& configJs,
+    const std::shared_ptr<const auth::TokenSigner>& tokenSigner,
+    const APIRequestHandler& apiRequestHandler,
+    GMainContext* context) noexcept :
+    _p(std::make_unique<Private>(
+        this,
+        config,
+        configJs,
+        nullptr,
+        tokenSigner,
+        OnNewAuthToken(),
+        apiRequestHandler,
+        context))
+{
+}
+
 MicroServer::~MicroServer()
 {
 }
 
+void MicroServer::setAsyncAPIRequestHandler(const AsyncAPIRequestHandler& handler) noexcept
+{
+    _p->asyncApiRequestHandler = handler;
+}
+
+void MicroServer::setCreateSession(const CreateSession& createSession) noexcept
+{
+    if(!createSession) {
+        _p->webRTCEndpoints.reset();
+        return;
+    }
+
+    _p->webRTCEndpoints = std::make_unique<WebRTCEndpoints>(_p->config, createSession, _p->context);
+}
+
 bool MicroServer::init() noexcept
 {
     return _p->init();
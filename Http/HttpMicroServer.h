@@ -7,6 +7,10 @@
 
 #include <glib.h>
 
+#include "Auth/TokenStore.h"
+#include "Auth/TokenSigner.h"
+#include "RtspSession/ServerSession.h"
+
 #include "Config.h"
 
 struct MHD_Response;
@@ -27,10 +31,6 @@ enum class Method
 class MicroServer
 {
 public:
-    struct AuthCookieData {
-        std::chrono::steady_clock::time_point expiresAt;
-        // FIXME! add allowed IP
-    };
     typedef std::function<void (
         const std::string& token,
         std::chrono::steady_clock::time_point expiresAt)> OnNewAuthToken;
@@ -38,12 +38,24 @@ public:
         Method method,
         const char* uri,
         const std::string_view& body)> APIRequestHandler;
+    // takes ownership of MHD_Response, can be called from any thread,
+    // but only the first call has effect
+    typedef std::function<void (unsigned responseCode, MHD_Response*)> APIResponder;
+    typedef std::function<void (
+        Method method,
+        const std::string& uri,
+        const std::string& body,
+        const APIResponder&)> AsyncAPIRequestHandler;
+    typedef std::function<
+        std::unique_ptr<rtsp::ServerSession> (
+            const rtsp::Session::SendRequest& sendRequest,
+            const rtsp::Session::SendResponse& sendResponse)> CreateSession;
 
     MicroServer(
         const Config&,
         const std::string& configJs,
         const OnNewAuthToken&,
-        const APIRequestHandler&, // will be called from worker thread
+        const APIRequestHandler&, // will be called from worker thread(s)
         GMainContext* context) noexcept;
     MicroServer(
         const Config& config,
@@ -51,6 +63,30 @@ public:
         const OnNewAuthToken& newAuthTokenHandler,
         GMainContext* context) noexcept :
         MicroServer(config, configJs, newAuthTokenHandler, APIRequestHandler(), context) {}
+    // issued auth tokens are put directly to tokenStore
+    // which can be shared with other auth cookie consumers (i.e. signalling::WsServer)
+    MicroServer(
+        const Config&,
+        const std::string& configJs,
+        const std::shared_ptr<auth::TokenStore>& tokenStore,
+        const APIRequestHandler&, // will be called from worker thread(s)
+        GMainContext* context) noexcept;
+    // issued auth tokens are self-contained and signed with tokenSigner,
+    // so anyone having the same keys can verify them without any shared state
+    MicroServer(
+        const Config&,
+        const std::string& configJs,
+        const std::shared_ptr<const auth::TokenSigner>& tokenSigner,
+        const APIRequestHandler&, // will be called from worker thread(s)
+        GMainContext* context) noexcept;
+    // if set it's used instead of APIRequestHandler and called on GMainContext thread.
+    // HTTP connection is suspended until APIResponder is called or Config::asyncApiTimeout expires.
+    // should be called before init()
+    void setAsyncAPIRequestHandler(const AsyncAPIRequestHandler&) noexcept;
+    // enables playback/WHIP endpoints (Config::playPrefix/whipPrefix) backed by sessions
+    // created with createSession on GMainContext thread.
+    // should be called before init()
+    void setCreateSession(const CreateSession&) noexcept;
     bool init() noexcept;
     ~MicroServer();
 
@@ -10,7 +10,7 @@ static std::shared_ptr<spdlog::logger> HttpServerLogger;
 void InitHttpServerLogger(spdlog::level::level_enum level)
 {
     if(!HttpServerLogger) {
-        HttpServerLogger = spdlog::stdout_logger_st("HttpServer");
+        HttpServerLogger = spdlog::stdout_logger_mt("HttpServer");
 #ifdef SNAPCRAFT_BUILD
         HttpServerLogger->set_pattern("[%n] [%l] %v");
 #endif
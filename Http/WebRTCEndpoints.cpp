@@ -0,0 +1,877 @@
+#include "WebRTCEndpoints.h"
+
+#include <map>
+#include <deque>
+#include <algorithm>
+#include <functional>
+
+#include <microhttpd.h>
+
+#include <CxxPtr/GlibPtr.h>
+
+#include "RtspParser/RtspParser.h"
+
+#include "Log.h"
+
+
+namespace http {
+
+namespace {
+
+const auto Log = HttpServerLog;
+
+enum {
+    SETUP_TIMEOUT = 30, // seconds
+};
+
+const char *const CandidatePrefix = "candidate:";
+const char *const TrickleIceContentType = "application/trickle-ice-sdpfrag";
+
+struct IceCandidate
+{
+    unsigned mlineIndex;
+    std::string candidate;
+};
+
+MHD_Response* CreateTextResponse(const std::string& text)
+{
+    return
+        MHD_create_response_from_buffer(
+            text.size(),
+            const_cast<char*>(text.data()),
+            MHD_RESPMEM_MUST_COPY);
+}
+
+// inserts "a=candidate" lines at the end of corresponding media sections
+std::string EmbedIceCandidates(const std::string& sdp, const std::deque<IceCandidate>& candidates)
+{
+    std::string out;
+    out.reserve(sdp.size() + candidates.size() * 128);
+
+    auto appendCandidates = [&out, &candidates] (int mlineIndex) {
+        if(mlineIndex < 0)
+            return;
+
+        for(const IceCandidate& c: candidates) {
+            if(c.mlineIndex != static_cast<unsigned>(mlineIndex))
+                continue;
+
+            out += "a=";
+            if(!g_str_has_prefix(c.candidate.c_str(), CandidatePrefix))
+                out += CandidatePrefix;
+            out += c.candidate;
+            out += "\r\n";
+        }
+    };
+
+    int mlineIndex = -1;
+    std::string::size_type pos = 0;
+    while(pos < sdp.size()) {
+        std::string::size_type lineEndPos = sdp.find('\n', pos);
+        if(lineEndPos == std::string::npos)
+            lineEndPos = sdp.size();
+
+        std::string::size_type lineSize = lineEndPos - pos;
+        if(lineSize && sdp[pos + lineSize - 1] == '\r')
+            --lineSize;
+
+        if(sdp.compare(pos, 2, "m=") == 0) {
+            appendCandidates(mlineIndex);
+            ++mlineIndex;
+        }
+
+        if(lineSize) {
+            out.append(sdp, pos, lineSize);
+            out += "\r\n";
+        }
+
+        pos = lineEndPos + 1;
+    }
+
+    appendCandidates(mlineIndex);
+
+    return out;
+}
+
+// calls onLine for every SDP line without line ending, with index of media section it belongs to
+void ForEachSdpLine(
+    const std::string& sdp,
+    const std::function<void (int mlineIndex, const std::string& line)>& onLine)
+{
+    int mlineIndex = -1;
+    std::string::size_type pos = 0;
+    while(pos < sdp.size()) {
+        std::string::size_type lineEndPos = sdp.find('\n', pos);
+        if(lineEndPos == std::string::npos)
+            lineEndPos = sdp.size();
+
+        std::string::size_type lineSize = lineEndPos - pos;
+        if(lineSize && sdp[pos + lineSize - 1] == '\r')
+            --lineSize;
+
+        if(sdp.compare(pos, 2, "m=") == 0)
+            ++mlineIndex;
+
+        if(lineSize)
+            onLine(mlineIndex, sdp.substr(pos, lineSize));
+
+        pos = lineEndPos + 1;
+    }
+}
+
+bool IsTrickleIceOffer(const std::string& sdp)
+{
+    bool trickle = false;
+    ForEachSdpLine(sdp, [&trickle] (int, const std::string& line) {
+        if(g_str_has_prefix(line.c_str(), "a=ice-options:") && line.find("trickle") != std::string::npos)
+            trickle = true;
+    });
+
+    return trickle;
+}
+
+// RFC 8840 SDP fragment -> candidates, "a=mid" is resolved to media section index of sdp
+std::deque<IceCandidate> ParseIceFragment(const std::string& fragment, const std::string& sdp)
+{
+    std::map<std::string, unsigned> mids;
+    ForEachSdpLine(sdp, [&mids] (int mlineIndex, const std::string& line) {
+        if(mlineIndex >= 0 && g_str_has_prefix(line.c_str(), "a=mid:"))
+            mids.emplace(line.substr(6), mlineIndex);
+    });
+
+    std::deque<IceCandidate> candidates;
+    int midIndex = -1;
+    ForEachSdpLine(fragment, [&] (int mlineIndex, const std::string& line) {
+        if(g_str_has_prefix(line.c_str(), "m=")) {
+            midIndex = -1;
+        } else if(g_str_has_prefix(line.c_str(), "a=mid:")) {
+            auto it = mids.find(line.substr(6));
+            midIndex = it != mids.end() ? static_cast<int>(it->second) : -1;
+        } else if(g_str_has_prefix(line.c_str(), "a=candidate:")) {
+            const int index = midIndex >= 0 ? midIndex : std::max(mlineIndex, 0);
+            candidates.emplace_back(IceCandidate { static_cast<unsigned>(index), line.substr(2) });
+        }
+    });
+
+    return candidates;
+}
+
+// RFC 8840 SDP fragment with candidates for corresponding media sections of sdp
+std::string BuildIceFragment(const std::string& sdp, const std::deque<IceCandidate>& candidates)
+{
+    std::string ufrag;
+    std::string pwd;
+    std::map<unsigned, std::string> sections; // "m=" and "a=mid" lines
+    ForEachSdpLine(sdp, [&] (int mlineIndex, const std::string& line) {
+        if(ufrag.empty() && g_str_has_prefix(line.c_str(), "a=ice-ufrag:"))
+            ufrag = line + "\r\n";
+        else if(pwd.empty() && g_str_has_prefix(line.c_str(), "a=ice-pwd:"))
+            pwd = line + "\r\n";
+        else if(mlineIndex >= 0 &&
+            (g_str_has_prefix(line.c_str(), "m=") || g_str_has_prefix(line.c_str(), "a=mid:")))
+        {
+            sections[mlineIndex] += line + "\r\n";
+        }
+    });
+
+    std::string out = ufrag + pwd;
+    for(const auto& [mlineIndex, section]: sections) {
+        bool sectionAdded = false;
+        for(const IceCandidate& c: candidates) {
+            if(c.mlineIndex != mlineIndex)
+                continue;
+
+            if(!sectionAdded) {
+                out += section;
+                sectionAdded = true;
+            }
+
+            out += "a=";
+            if(!g_str_has_prefix(c.candidate.c_str(), CandidatePrefix))
+                out += CandidatePrefix;
+            out += c.candidate;
+            out += "\r\n";
+        }
+    }
+
+    return out;
+}
+
+unsigned HttpStatusCode(unsigned rtspStatusCode)
+{
+    if(rtspStatusCode >= 400 && rtspStatusCode < 500 && rtspStatusCode != rtsp::SESSION_NOT_FOUND)
+        return rtspStatusCode;
+    else if(rtspStatusCode == rtsp::SERVICE_UNAVAILABLE)
+        return MHD_HTTP_SERVICE_UNAVAILABLE;
+    else
+        return MHD_HTTP_BAD_GATEWAY;
+}
+
+}
+
+struct WebRTCEndpoints::Private
+{
+    struct Resource
+    {
+        enum class Type {
+            Play,
+            Whip,
+        };
+
+        Resource(
+            Type type,
+            const std::string& id,
+            const std::string& uri,
+            const std::optional<std::string>& authToken,
+            bool trickleIce) :
+            type(type), id(id), uri(uri), authToken(authToken), trickleIce(trickleIce) {}
+        ~Resource()
+        {
+            if(timeoutSourcePtr)
+                g_source_destroy(timeoutSourcePtr.get());
+        }
+
+        const Type type;
+        const std::string id;
+        const std::string uri;
+        const std::optional<std::string> authToken;
+        // client will send trickle ICE PATCH, so there is no need to wait for local candidates
+        const bool trickleIce;
+
+        std::unique_ptr<rtsp::ServerSession> session;
+        rtsp::CSeq nextCSeq = 1;
+        rtsp::MediaSessionId mediaSession;
+
+        // HTTP request waiting for response from session
+        rtsp::CSeq pendingCSeq = 0;
+        MicroServer::APIResponder pendingResponder;
+
+        std::string localSdp;
+        // not yet delivered to client. After SDP is sent they go with trickle ICE PATCH response
+        std::deque<IceCandidate> iceCandidates;
+        // from client, waiting for PLAY
+        std::deque<IceCandidate> remoteIceCandidates;
+        bool sdpSent = false;
+        bool playing = false;
+
+        GSourcePtr timeoutSourcePtr;
+    };
+
+    Private(const Config&, const CreateSession&, GMainContext*);
+
+    std::weak_ptr<Private> self;
+
+    const std::optional<std::string> playPrefix;
+    const std::optional<std::string> whipPrefix;
+    const unsigned iceGatheringTime;
+    const unsigned resourceIdleTimeout;
+    const CreateSession createSession;
+    GMainContext *const context;
+
+    std::map<std::string, std::unique_ptr<Resource>> resources;
+
+    Resource* findResource(const std::string& id);
+    Resource* findResource(const std::string& prefix, Resource::Type, const std::string& path);
+    std::string resourcePath(const Resource&) const;
+
+    void createResource(Resource::Type, const Request&, const MicroServer::APIResponder&);
+    void updateResource(Resource*, const Request&, const MicroServer::APIResponder&);
+    void trickleIce(Resource*, const Request&, const MicroServer::APIResponder&);
+    void sendIceCandidates(Resource*, const std::deque<IceCandidate>&);
+    void deleteResource(Resource*, const MicroServer::APIResponder&);
+
+    bool sendToSession(Resource*, rtsp::Method, const std::string& contentType, const std::string& body);
+
+    void onSessionRequest(const std::string& id, const rtsp::Request*);
+    void onSessionResponse(const std::string& id, const rtsp::Response*);
+    void respondWithSdp(Resource*);
+    void respond(Resource*, unsigned statusCode, MHD_Response*);
+
+    void startTimer(Resource*, guint interval, bool seconds, void (Private::*)(Resource*));
+    void setupTimeout(Resource*);
+    void refreshIdleTimeout(Resource*);
+    void idleTimeout(Resource*);
+
+    void close(const std::string& id);
+};
+
+WebRTCEndpoints::Private::Private(
+    const Config& config,
+    const CreateSession& createSession,
+    GMainContext* context) :
+    playPrefix(config.playPrefix),
+    whipPrefix(config.whipPrefix),
+    iceGatheringTime(config.iceGatheringTime),
+    resourceIdleTimeout(config.resourceIdleTimeout),
+    createSession(createSession),
+    context(context)
+{
+}
+
+WebRTCEndpoints::Private::Resource* WebRTCEndpoints::Private::findResource(const std::string& id)
+{
+    auto it = resources.find(id);
+    return it != resources.end() ? it->second.get() : nullptr;
+}
+
+// resource path is "<prefix>/<uri>/<resource id>"
+WebRTCEndpoints::Private::Resource* WebRTCEndpoints::Private::findResource(
+    const std::string& prefix,
+    Resource::Type type,
+    const std::string& path)
+{
+    const std::string::size_type idPos = path.rfind('/');
+    Resource* resource =
+        idPos > prefix.size() ?
+            findResource(path.substr(idPos + 1)) :
+            nullptr;
+    if(!resource || resource->type != type || resourcePath(*resource) != path)
+        return nullptr;
+
+    return resource;
+}
+
+std::string WebRTCEndpoints::Private::resourcePath(const Resource& resource) const
+{
+    const std::string& prefix =
+        resource.type == Resource::Type::Play ? playPrefix.value() : whipPrefix.value();
+
+    return prefix + "/" + resource.uri + "/" + resource.id;
+}
+
+void WebRTCEndpoints::Private::startTimer(
+    Resource* resource,
+    guint interval,
+    bool seconds,
+    void (Private::*handler)(Resource*))
+{
+    if(resource->timeoutSourcePtr)
+        g_source_destroy(resource->timeoutSourcePtr.get());
+
+    resource->timeoutSourcePtr.reset(
+        seconds ? g_timeout_source_new_seconds(interval) : g_timeout_source_new(interval));
+    GSource* timeoutSource = resource->timeoutSourcePtr.get();
+
+    struct CallbackData {
+        std::weak_ptr<Private> self;
+        std::string id;
+        void (Private::*handler)(Resource*);
+    };
+    g_source_set_callback(
+        timeoutSource,
+        [] (gpointer userData) -> gboolean {
+            const CallbackData* callbackData = reinterpret_cast<CallbackData*>(userData);
+
+            std::shared_ptr<Private> self = callbackData->self.lock();
+            if(!self)
+                return G_SOURCE_REMOVE;
+
+            if(Resource* resource = self->findResource(callbackData->id)) {
+                resource->timeoutSourcePtr.reset();
+                (self.get()->*callbackData->handler)(resource);
+            }
+
+            return G_SOURCE_REMOVE;
+        },
+        new CallbackData { self, resource->id, handler },
+        [] (gpointer userData) {
+            delete reinterpret_cast<CallbackData*>(userData);
+        });
+    g_source_attach(timeoutSource, context);
+}
+
+void WebRTCEndpoints::Private::createResource(
+    Resource::Type type,
+    const Request& request,
+    const MicroServer::APIResponder& responder)
+{
+    const std::string& prefix = type == Resource::Type::Play ? playPrefix.value() : whipPrefix.value();
+    const std::string uri = request.path.substr(prefix.size() + 1);
+    if(uri.empty()) {
+        responder(MHD_HTTP_NOT_FOUND, CreateTextResponse("Not found"));
+        return;
+    }
+
+    if(type == Resource::Type::Whip) {
+        if(request.contentType != rtsp::SdpContentType || request.body.empty()) {
+            responder(MHD_HTTP_UNSUPPORTED_MEDIA_TYPE, CreateTextResponse("SDP offer expected"));
+            return;
+        }
+    } else if(!request.body.empty()) {
+        // server side peers are always offerers, so it's not WHEP
+        responder(MHD_HTTP_UNSUPPORTED_MEDIA_TYPE, CreateTextResponse("Empty body expected"));
+        return;
+    }
+
+    const std::string id = GCharPtr(g_uuid_string_random()).get();
+
+    auto resourcePtr =
+        std::make_unique<Resource>(
+            type,
+            id,
+            uri,
+            request.authToken,
+            type == Resource::Type::Whip && IsTrickleIceOffer(request.body));
+    Resource* resource = resourcePtr.get();
+    resources.emplace(id, std::move(resourcePtr));
+
+    std::weak_ptr<Private> weakSelf = self;
+    resource->session =
+        createSession(
+            [weakSelf, id] (const rtsp::Request* request) {
+                if(std::shared_ptr<Private> self = weakSelf.lock())
+                    self->onSessionRequest(id, request);
+            },
+            [weakSelf, id] (const rtsp::Response* response) {
+                if(std::shared_ptr<Private> self = weakSelf.lock())
+                    self->onSessionResponse(id, response);
+            });
+    if(!resource->session || !resource->session->onConnected(request.authCookie)) {
+        Log()->error("Failed to create session for \"{}\"", request.path);
+        resources.erase(id);
+        responder(MHD_HTTP_SERVICE_UNAVAILABLE, CreateTextResponse("Service unavailable"));
+        return;
+    }
+
+    resource->pendingResponder = responder;
+
+    startTimer(resource, SETUP_TIMEOUT, true, &Private::setupTimeout);
+
+    const bool sent =
+        type == Resource::Type::Play ?
+            sendToSession(resource, rtsp::Method::DESCRIBE, std::string(), std::string()) :
+            sendToSession(resource, rtsp::Method::RECORD, rtsp::SdpContentType, request.body);
+    if(!sent) {
+        respond(resource, MHD_HTTP_FORBIDDEN, CreateTextResponse("Forbidden"));
+        close(id);
+    }
+}
+
+void WebRTCEndpoints::Private::updateResource(
+    Resource* resource,
+    const Request& request,
+    const MicroServer::APIResponder& responder)
+{
+    if(request.contentType == TrickleIceContentType) {
+        trickleIce(resource, request, responder);
+        return;
+    }
+
+    if(resource->type != Resource::Type::Play ||
+        request.contentType != rtsp::SdpContentType || request.body.empty())
+    {
+        responder(MHD_HTTP_UNSUPPORTED_MEDIA_TYPE, CreateTextResponse("SDP answer or trickle ICE expected"));
+        return;
+    }
+
+    if(!resource->sdpSent || resource->playing || resource->pendingResponder) {
+        responder(MHD_HTTP_CONFLICT, CreateTextResponse("Conflict"));
+        return;
+    }
+
+    resource->pendingResponder = responder;
+
+    if(!sendToSession(resource, rtsp::Method::PLAY, rtsp::SdpContentType, request.body))
+        respond(resource, MHD_HTTP_BAD_REQUEST, CreateTextResponse("Bad request"));
+}
+
+void WebRTCEndpoints::Private::trickleIce(
+    Resource* resource,
+    const Request& request,
+    const MicroServer::APIResponder& responder)
+{
+    if(!resource->sdpSent) {
+        responder(MHD_HTTP_CONFLICT, CreateTextResponse("Conflict"));
+        return;
+    }
+
+    const std::deque<IceCandidate> candidates = ParseIceFragment(request.body, resource->localSdp);
+    if(resource->type == Resource::Type::Play && !resource->playing) {
+        // remote SDP is not applied yet
+        resource->remoteIceCandidates.insert(
+            resource->remoteIceCandidates.end(),
+            candidates.begin(),
+            candidates.end());
+    } else {
+        sendIceCandidates(resource, candidates);
+    }
+
+    refreshIdleTimeout(resource);
+
+    // local candidates gathered after SDP was sent
+    if(resource->iceCandidates.empty()) {
+        responder(MHD_HTTP_NO_CONTENT, CreateTextResponse(std::string()));
+        return;
+    }
+
+    MHD_Response* response =
+        CreateTextResponse(BuildIceFragment(resource->localSdp, resource->iceCandidates));
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, TrickleIceContentType);
+    resource->iceCandidates.clear();
+
+    responder(MHD_HTTP_OK, response);
+}
+
+void WebRTCEndpoints::Private::sendIceCandidates(
+    Resource* resource,
+    const std::deque<IceCandidate>& candidates)
+{
+    if(candidates.empty())
+        return;
+
+    std::string body;
+    for(const IceCandidate& c: candidates)
+        body += std::to_string(c.mlineIndex) + "/" + c.candidate + "\r\n";
+
+    sendToSession(resource, rtsp::Method::SETUP, rtsp::IceCandidateContentType, body);
+}
+
+void WebRTCEndpoints::Private::deleteResource(
+    Resource* resource,
+    const MicroServer::APIResponder& responder)
+{
+    if(!resource->mediaSession.empty())
+        sendToSession(resource, rtsp::Method::TEARDOWN, std::string(), std::string());
+
+    responder(MHD_HTTP_OK, CreateTextResponse(std::string()));
+
+    close(resource->id);
+}
+
+bool WebRTCEndpoints::Private::sendToSession(
+    Resource* resource,
+    rtsp::Method method,
+    const std::string& contentType,
+    const std::string& body)
+{
+    std::unique_ptr<rtsp::Request> requestPtr = std::make_unique<rtsp::Request>();
+    requestPtr->method = method;
+    requestPtr->uri = resource->uri;
+    requestPtr->cseq = resource->nextCSeq++;
+    if(!resource->mediaSession.empty())
+        rtsp::SetRequestSession(requestPtr.get(), resource->mediaSession);
+    if(!contentType.empty())
+        rtsp::SetContentType(requestPtr.get(), contentType);
+    if(resource->authToken)
+        rtsp::SetBearerAuthorization(requestPtr.get(), *resource->authToken);
+    requestPtr->body = body;
+
+    // HTTP client doesn't wait for TEARDOWN and SETUP
+    if(method != rtsp::Method::TEARDOWN && method != rtsp::Method::SETUP)
+        resource->pendingCSeq = requestPtr->cseq;
+
+    return resource->session->handleRequest(std::move(requestPtr));
+}
+
+void WebRTCEndpoints::Private::onSessionRequest(
+    const std::string& id,
+    const rtsp::Request* request)
+{
+    Resource* resource = findResource(id);
+    if(!resource)
+        return;
+
+    if(!request) {
+        // session requested disconnect
+        respond(resource, MHD_HTTP_BAD_GATEWAY, CreateTextResponse("Bad gateway"));
+        close(id);
+        return;
+    }
+
+    switch(request->method) {
+    case rtsp::Method::SETUP: {
+        // candidates gathered after SDP was sent are delivered with trickle ICE PATCH response
+        const std::string& ice = request->body;
+        std::string::size_type pos = 0;
+        while(pos < ice.size()) {
+            std::string::size_type lineEndPos = ice.find("\r\n", pos);
+            if(lineEndPos == std::string::npos)
+                break;
+            lineEndPos += 2;
+
+            if(auto candidate = rtsp::ParseIceCandidate(ice.substr(pos, lineEndPos - pos)))
+                resource->iceCandidates.emplace_back(IceCandidate { candidate->first, candidate->second });
+
+            pos = lineEndPos;
+        }
+        break;
+    }
+    case rtsp::Method::TEARDOWN:
+        close(id);
+        return;
+    default:
+        break;
+    }
+
+    // session expects response to every request
+    auto responsePtr = std::make_unique<rtsp::Response>();
+    responsePtr->protocol = request->protocol;
+    responsePtr->statusCode = rtsp::OK;
+    responsePtr->reasonPhrase = "OK";
+    responsePtr->cseq = request->cseq;
+    const rtsp::MediaSessionId mediaSession = rtsp::RequestSession(*request);
+    if(!mediaSession.empty())
+        rtsp::SetResponseSession(responsePtr.get(), mediaSession);
+
+    // session is still on call stack, so deliver it on next iteration
+    struct CallbackData {
+        std::weak_ptr<Private> self;
+        std::string id;
+        std::unique_ptr<rtsp::Response> responsePtr;
+    };
+    GSourcePtr idleSourcePtr(g_idle_source_new());
+    g_source_set_callback(
+        idleSourcePtr.get(),
+        [] (gpointer userData) -> gboolean {
+            CallbackData* callbackData = reinterpret_cast<CallbackData*>(userData);
+
+            std::shared_ptr<Private> self = callbackData->self.lock();
+            if(!self)
+                return G_SOURCE_REMOVE;
+
+            Resource* resource = self->findResource(callbackData->id);
+            if(resource && resource->session &&
+                !resource->session->handleResponse(std::move(callbackData->responsePtr)))
+            {
+                self->close(callbackData->id);
+            }
+
+            return G_SOURCE_REMOVE;
+        },
+        new CallbackData { self, id, std::move(responsePtr) },
+        [] (gpointer userData) {
+            delete reinterpret_cast<CallbackData*>(userData);
+        });
+    g_source_attach(idleSourcePtr.get(), context);
+}
+
+void WebRTCEndpoints::Private::onSessionResponse(
+    const std::string& id,
+    const rtsp::Response* response)
+{
+    Resource* resource = findResource(id);
+    if(!resource)
+        return;
+
+    if(!response) {
+        respond(resource, MHD_HTTP_BAD_GATEWAY, CreateTextResponse("Bad gateway"));
+        close(id);
+        return;
+    }
+
+    if(response->cseq != resource->pendingCSeq)
+        return;
+
+    resource->pendingCSeq = 0;
+
+    if(response->statusCode != rtsp::OK) {
+        respond(
+            resource,
+            HttpStatusCode(response->statusCode),
+            CreateTextResponse(response->reasonPhrase));
+        if(!resource->sdpSent)
+            close(id);
+        return;
+    }
+
+    if(!resource->sdpSent) {
+        resource->mediaSession = rtsp::ResponseSession(*response);
+        resource->localSdp = response->body;
+
+        if(resource->mediaSession.empty() || resource->localSdp.empty()) {
+            respond(resource, MHD_HTTP_BAD_GATEWAY, CreateTextResponse("Bad gateway"));
+            close(id);
+            return;
+        }
+
+        // give local candidates a chance to be gathered for clients without trickle ICE.
+        // Late candidates are still delivered if client sends trickle ICE PATCH
+        if(iceGatheringTime && !resource->trickleIce)
+            startTimer(resource, iceGatheringTime, false, &Private::respondWithSdp);
+        else
+            respondWithSdp(resource);
+    } else {
+        resource->playing = true;
+
+        respond(resource, MHD_HTTP_NO_CONTENT, CreateTextResponse(std::string()));
+
+        sendIceCandidates(resource, resource->remoteIceCandidates);
+        resource->remoteIceCandidates.clear();
+
+        refreshIdleTimeout(resource);
+    }
+}
+
+void WebRTCEndpoints::Private::respondWithSdp(Resource* resource)
+{
+    const std::string sdp = EmbedIceCandidates(resource->localSdp, resource->iceCandidates);
+
+    MHD_Response* response = CreateTextResponse(sdp);
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, rtsp::SdpContentType);
+    MHD_add_response_header(response, MHD_HTTP_HEADER_LOCATION, resourcePath(*resource).c_str());
+    MHD_add_response_header(response, "Accept-Patch", TrickleIceContentType);
+
+    resource->sdpSent = true;
+    resource->iceCandidates.clear();
+
+    respond(resource, MHD_HTTP_CREATED, response);
+
+    if(resource->type == Resource::Type::Play)
+        startTimer(resource, SETUP_TIMEOUT, true, &Private::setupTimeout);
+    else
+        refreshIdleTimeout(resource);
+}
+
+void WebRTCEndpoints::Private::respond(
+    Resource* resource,
+    unsigned statusCode,
+    MHD_Response* response)
+{
+    MicroServer::APIResponder responder;
+    std::swap(responder, resource->pendingResponder);
+
+    if(responder)
+        responder(statusCode, response);
+    else
+        MHD_destroy_response(response);
+}
+
+void WebRTCEndpoints::Private::setupTimeout(Resource* resource)
+{
+    if(resource->playing || (resource->type == Resource::Type::Whip && resource->sdpSent))
+        return;
+
+    Log()->warn("WebRTC endpoint resource \"{}\" setup timeout", resourcePath(*resource));
+
+    respond(resource, MHD_HTTP_GATEWAY_TIMEOUT, CreateTextResponse("Timeout"));
+
+    close(resource->id);
+}
+
+void WebRTCEndpoints::Private::refreshIdleTimeout(Resource* resource)
+{
+    const bool established =
+        resource->playing || (resource->type == Resource::Type::Whip && resource->sdpSent);
+    if(!resourceIdleTimeout || !established)
+        return;
+
+    startTimer(resource, resourceIdleTimeout, true, &Private::idleTimeout);
+}
+
+void WebRTCEndpoints::Private::idleTimeout(Resource* resource)
+{
+    Log()->info("WebRTC endpoint resource \"{}\" idle timeout", resourcePath(*resource));
+
+    if(!resource->mediaSession.empty())
+        sendToSession(resource, rtsp::Method::TEARDOWN, std::string(), std::string());
+
+    close(resource->id);
+}
+
+void WebRTCEndpoints::Private::close(const std::string& id)
+{
+    Resource* resource = findResource(id);
+    if(!resource)
+        return;
+
+    respond(resource, MHD_HTTP_BAD_GATEWAY, CreateTextResponse("Bad gateway"));
+
+    // session can be still on call stack, so destroy it on next iteration
+    auto it = resources.find(id);
+    Resource* closingResource = it->second.release();
+    resources.erase(it);
+
+    GSourcePtr idleSourcePtr(g_idle_source_new());
+    g_source_set_callback(
+        idleSourcePtr.get(),
+        [] (gpointer) -> gboolean {
+            return G_SOURCE_REMOVE;
+        },
+        closingResource,
+        [] (gpointer userData) {
+            delete reinterpret_cast<Resource*>(userData);
+        });
+    g_source_attach(idleSourcePtr.get(), context);
+}
+
+
+WebRTCEndpoints::WebRTCEndpoints(
+    const Config& config,
+    const CreateSession& createSession,
+    GMainContext* context) noexcept :
+    _p(std::make_shared<Private>(config, createSession, context))
+{
+    _p->self = _p;
+}
+
+WebRTCEndpoints::~WebRTCEndpoints()
+{
+}
+
+bool WebRTCEndpoints::isEndpointPath(const char* path) const noexcept
+{
+    auto hasPrefix = [path] (const std::optional<std::string>& prefix) {
+        return prefix &&
+            g_str_has_prefix(path, prefix->c_str()) &&
+            path[prefix->size()] == '/';
+    };
+
+    return hasPrefix(_p->playPrefix) || hasPrefix(_p->whipPrefix);
+}
+
+void WebRTCEndpoints::handleRequest(
+    const Request& request,
+    const MicroServer::APIResponder& responder) noexcept
+{
+    Private::Resource::Type type;
+    const std::string* prefix;
+    if(_p->playPrefix && g_str_has_prefix(request.path.c_str(), (*_p->playPrefix + "/").c_str())) {
+        type = Private::Resource::Type::Play;
+        prefix = &_p->playPrefix.value();
+    } else if(_p->whipPrefix && g_str_has_prefix(request.path.c_str(), (*_p->whipPrefix + "/").c_str())) {
+        type = Private::Resource::Type::Whip;
+        prefix = &_p->whipPrefix.value();
+    } else {
+        responder(MHD_HTTP_NOT_FOUND, CreateTextResponse("Not found"));
+        return;
+    }
+
+    if(request.method == Method::OPTIONS) {
+        // can be used by client to keep resource alive
+        if(Private::Resource* resource = _p->findResource(*prefix, type, request.path))
+            _p->refreshIdleTimeout(resource);
+
+        MHD_Response* response = CreateTextResponse(std::string());
+        // playback resource is created with empty POST
+        if(type == Private::Resource::Type::Whip)
+            MHD_add_response_header(response, "Accept-Post", rtsp::SdpContentType);
+        MHD_add_response_header(response, "Accept-Patch", TrickleIceContentType);
+        responder(MHD_HTTP_NO_CONTENT, response);
+        return;
+    }
+
+    if(request.method == Method::POST) {
+        _p->createResource(type, request, responder);
+        return;
+    }
+
+    Private::Resource* resource = _p->findResource(*prefix, type, request.path);
+    if(!resource) {
+        responder(MHD_HTTP_NOT_FOUND, CreateTextResponse("Not found"));
+        return;
+    }
+
+    switch(request.method) {
+    case Method::PATCH:
+        _p->updateResource(resource, request, responder);
+        break;
+    case Method::DELETE:
+        _p->deleteResource(resource, responder);
+        break;
+    default:
+        responder(MHD_HTTP_METHOD_NOT_ALLOWED, CreateTextResponse("Method not allowed"));
+        break;
+    }
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <optional>
+#include <functional>
+
+#include <glib.h>
+
+#include "Config.h"
+#include "HttpMicroServer.h"
+
+
+namespace http {
+
+// WHIP (ingest) endpoint and WebRTSP specific HTTP playback endpoint.
+// Playback endpoint is not WHEP: server side peers are always offerers,
+// so POST with empty body is answered with server generated SDP offer
+// and client sends its SDP answer with PATCH to the returned resource.
+// Both accept trickle ICE PATCH, answered with local candidates gathered after SDP was sent.
+// Every HTTP resource drives its own rtsp::ServerSession with in-process RTSP requests,
+// so the same streamers, peers and authorization are used as for WebSocket clients.
+class WebRTCEndpoints
+{
+public:
+    typedef MicroServer::CreateSession CreateSession;
+
+    struct Request
+    {
+        Method method;
+        std::string path;
+        std::string contentType;
+        std::optional<std::string> authToken; // from Bearer authorization
+        std::optional<std::string> authCookie; // already validated
+        std::string body;
+    };
+
+    WebRTCEndpoints(const Config&, const CreateSession&, GMainContext*) noexcept;
+    ~WebRTCEndpoints();
+
+    // can be called from any thread
+    bool isEndpointPath(const char* path) const noexcept;
+
+    // should be called on GMainContext thread
+    void handleRequest(const Request&, const MicroServer::APIResponder&) noexcept;
+
+private:
+    struct Private;
+    std::shared_ptr<Private> _p;
+};
+
+}
@@ -0,0 +1,33 @@
+#include "Log.h"
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_sinks.h>
+
+
+static std::shared_ptr<spdlog::logger> MetricsLogger;
+
+
+void InitMetricsLogger(spdlog::level::level_enum level)
+{
+    if(!MetricsLogger) {
+        MetricsLogger = spdlog::stdout_logger_mt("Metrics");
+#ifdef SNAPCRAFT_BUILD
+        MetricsLogger->set_pattern("[%n] [%l] %v");
+#endif
+    }
+
+    MetricsLogger->set_level(level);
+}
+
+const std::shared_ptr<spdlog::logger>& MetricsLog()
+{
+    if(!MetricsLogger) {
+#ifdef NDEBUG
+        InitMetricsLogger(spdlog::level::info);
+#else
+        InitMetricsLogger(spdlog::level::debug);
+#endif
+    }
+
+    return MetricsLogger;
+}
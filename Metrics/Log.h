@@ -0,0 +1,9 @@
+#pragma once
+
+#include <memory>
+
+#include <spdlog/spdlog.h>
+
+
+void InitMetricsLogger(spdlog::level::level_enum level);
+const std::shared_ptr<spdlog::logger>& MetricsLog();
@@ -0,0 +1,311 @@
+#include "Metrics.h"
+
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#include "Log.h"
+
+
+namespace metrics {
+
+namespace {
+
+const auto Log = MetricsLog;
+
+unsigned ShardIndex() noexcept
+{
+    static std::atomic<unsigned> nextIndex = 0;
+    thread_local const unsigned index =
+        nextIndex.fetch_add(1, std::memory_order_relaxed) % SHARDS_COUNT;
+
+    return index;
+}
+
+std::string FormatNumber(double value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.17g", value);
+    return buffer;
+}
+
+std::string FormatLabels(const Labels& labels, const char* le = nullptr)
+{
+    if(labels.empty() && !le)
+        return std::string();
+
+    std::string out = "{";
+    for(const auto& [name, value]: labels) {
+        if(out.size() > 1)
+            out += ",";
+
+        out += name;
+        out += "=\"";
+        for(char c: value) {
+            switch(c) {
+            case '\\':
+                out += "\\\\";
+                break;
+            case '"':
+                out += "\\\"";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            default:
+                out += c;
+            }
+        }
+        out += "\"";
+    }
+
+    if(le) {
+        if(out.size() > 1)
+            out += ",";
+        out += "le=\"";
+        out += le;
+        out += "\"";
+    }
+
+    out += "}";
+
+    return out;
+}
+
+}
+
+void Counter::inc(uint64_t value) noexcept
+{
+    _shards[ShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t Counter::value() const noexcept
+{
+    uint64_t value = 0;
+    for(const Shard& shard: _shards)
+        value += shard.value.load(std::memory_order_relaxed);
+
+    return value;
+}
+
+
+struct alignas(64) Histogram::Shard
+{
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+    std::atomic<double> sum = 0;
+};
+
+Histogram::Histogram(const std::vector<double>& bounds) noexcept :
+    _bounds(bounds),
+    _shards(new Shard[SHARDS_COUNT])
+{
+    for(unsigned i = 0; i < SHARDS_COUNT; ++i)
+        _shards[i].buckets.reset(new std::atomic<uint64_t>[_bounds.size() + 1]());
+}
+
+Histogram::~Histogram()
+{
+}
+
+void Histogram::observe(double value) noexcept
+{
+    size_t bucket = 0;
+    while(bucket < _bounds.size() && value > _bounds[bucket])
+        ++bucket;
+
+    Shard& shard = _shards[ShardIndex()];
+    shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    double sum = shard.sum.load(std::memory_order_relaxed);
+    while(!shard.sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed));
+}
+
+Histogram::Snapshot Histogram::snapshot() const noexcept
+{
+    Snapshot snapshot;
+    snapshot.buckets.resize(_bounds.size() + 1);
+
+    for(unsigned i = 0; i < SHARDS_COUNT; ++i) {
+        const Shard& shard = _shards[i];
+        for(size_t bucket = 0; bucket < snapshot.buckets.size(); ++bucket)
+            snapshot.buckets[bucket] += shard.buckets[bucket].load(std::memory_order_relaxed);
+        snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+
+    for(size_t bucket = 1; bucket < snapshot.buckets.size(); ++bucket)
+        snapshot.buckets[bucket] += snapshot.buckets[bucket - 1];
+
+    return snapshot;
+}
+
+const std::vector<double>& LatencyBuckets() noexcept
+{
+    static const std::vector<double> buckets =
+        { 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10 };
+
+    return buckets;
+}
+
+
+struct Registry::Private
+{
+    enum class Type {
+        Counter,
+        Gauge,
+        Histogram,
+    };
+
+    struct Series
+    {
+        Labels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    struct Family
+    {
+        Type type;
+        std::string help;
+        std::map<std::string, Series> series; // formatted labels -> Series
+    };
+
+    Series& series(
+        const std::string& name,
+        const std::string& help,
+        Type type,
+        const Labels& labels);
+
+    mutable std::mutex mutex;
+    std::map<std::string, Family> families;
+    // handed out on family type mismatch, never serialized
+    std::deque<Series> detachedSeries;
+};
+
+Registry::Private::Series& Registry::Private::series(
+    const std::string& name,
+    const std::string& help,
+    Type type,
+    const Labels& labels)
+{
+    auto familyIt = families.find(name);
+    if(familyIt == families.end())
+        familyIt = families.emplace(name, Family { type, help, {} }).first;
+
+    Family& family = familyIt->second;
+    if(family.type != type) {
+        Log()->error("Metric \"{}\" is already registered with different type", name);
+        return detachedSeries.emplace_back();
+    }
+
+    Series& series = family.series[FormatLabels(labels)];
+    if(series.labels.empty())
+        series.labels = labels;
+
+    return series;
+}
+
+Registry& Registry::Default() noexcept
+{
+    static Registry registry;
+    return registry;
+}
+
+Registry::Registry() noexcept :
+    _p(std::make_unique<Private>())
+{
+}
+
+Registry::~Registry()
+{
+}
+
+Counter& Registry::counter(
+    const std::string& name,
+    const std::string& help,
+    const Labels& labels) noexcept
+{
+    std::lock_guard lock(_p->mutex);
+
+    Private::Series& series = _p->series(name, help, Private::Type::Counter, labels);
+    if(!series.counter)
+        series.counter = std::make_unique<Counter>();
+
+    return *series.counter;
+}
+
+Gauge& Registry::gauge(
+    const std::string& name,
+    const std::string& help,
+    const Labels& labels) noexcept
+{
+    std::lock_guard lock(_p->mutex);
+
+    Private::Series& series = _p->series(name, help, Private::Type::Gauge, labels);
+    if(!series.gauge)
+        series.gauge = std::make_unique<Gauge>();
+
+    return *series.gauge;
+}
+
+Histogram& Registry::histogram(
+    const std::string& name,
+    const std::string& help,
+    const std::vector<double>& bounds,
+    const Labels& labels) noexcept
+{
+    std::lock_guard lock(_p->mutex);
+
+    Private::Series& series = _p->series(name, help, Private::Type::Histogram, labels);
+    if(!series.histogram)
+        series.histogram = std::make_unique<Histogram>(bounds);
+
+    return *series.histogram;
+}
+
+std::string Registry::serialize() const noexcept
+{
+    std::string out;
+
+    std::lock_guard lock(_p->mutex);
+
+    for(const auto& [name, family]: _p->families) {
+        out += "# HELP " + name + " " + family.help + "\n";
+
+        switch(family.type) {
+        case Private::Type::Counter:
+            out += "# TYPE " + name + " counter\n";
+            for(const auto& [labels, series]: family.series)
+                out += name + labels + " " + std::to_string(series.counter->value()) + "\n";
+            break;
+        case Private::Type::Gauge:
+            out += "# TYPE " + name + " gauge\n";
+            for(const auto& [labels, series]: family.series)
+                out += name + labels + " " + std::to_string(series.gauge->value()) + "\n";
+            break;
+        case Private::Type::Histogram:
+            out += "# TYPE " + name + " histogram\n";
+            for(const auto& [labels, series]: family.series) {
+                const Histogram& histogram = *series.histogram;
+                const Histogram::Snapshot snapshot = histogram.snapshot();
+
+                for(size_t bucket = 0; bucket < snapshot.buckets.size(); ++bucket) {
+                    const std::string le =
+                        bucket < histogram.bounds().size() ?
+                            FormatNumber(histogram.bounds()[bucket]) :
+                            "+Inf";
+                    out += name + "_bucket" + FormatLabels(series.labels, le.c_str()) + " " +
+                        std::to_string(snapshot.buckets[bucket]) + "\n";
+                }
+                out += name + "_sum" + labels + " " + FormatNumber(snapshot.sum) + "\n";
+                out += name + "_count" + labels + " " + std::to_string(snapshot.buckets.back()) + "\n";
+            }
+            break;
+        }
+    }
+
+    return out;
+}
+
+}
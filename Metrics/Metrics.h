@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace metrics {
+
+typedef std::vector<std::pair<std::string, std::string>> Labels;
+
+const char *const PrometheusContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+enum {
+    SHARDS_COUNT = 16,
+};
+
+// Updates go to the shard bound to calling thread,
+// so concurrent updates from different threads don't fight for the same cache line.
+class Counter
+{
+public:
+    void inc(uint64_t value = 1) noexcept;
+    uint64_t value() const noexcept;
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> value = 0;
+    };
+
+    Shard _shards[SHARDS_COUNT];
+};
+
+class Gauge
+{
+public:
+    void inc(int64_t value = 1) noexcept
+        { _value.fetch_add(value, std::memory_order_relaxed); }
+    void dec(int64_t value = 1) noexcept
+        { _value.fetch_sub(value, std::memory_order_relaxed); }
+    void set(int64_t value) noexcept
+        { _value.store(value, std::memory_order_relaxed); }
+    int64_t value() const noexcept
+        { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> _value = 0;
+};
+
+class Histogram
+{
+public:
+    struct Snapshot
+    {
+        std::vector<uint64_t> buckets; // cumulative, last one is +Inf
+        double sum = 0;
+    };
+
+    // bounds are upper bounds of buckets in ascending order
+    explicit Histogram(const std::vector<double>& bounds) noexcept;
+    ~Histogram();
+
+    void observe(double value) noexcept;
+    void observe(std::chrono::steady_clock::duration duration) noexcept
+        { observe(std::chrono::duration<double>(duration).count()); }
+
+    const std::vector<double>& bounds() const noexcept
+        { return _bounds; }
+    Snapshot snapshot() const noexcept;
+
+private:
+    struct Shard;
+
+    const std::vector<double> _bounds;
+    std::unique_ptr<Shard[]> _shards;
+};
+
+// seconds, from 1ms to 10s
+const std::vector<double>& LatencyBuckets() noexcept;
+
+class Registry
+{
+public:
+    static Registry& Default() noexcept;
+
+    Registry() noexcept;
+    ~Registry();
+
+    // returned references stay valid during whole Registry lifetime,
+    // so it's expected they will be looked up once and cached
+    Counter& counter(
+        const std::string& name,
+        const std::string& help,
+        const Labels& = Labels()) noexcept;
+    Gauge& gauge(
+        const std::string& name,
+        const std::string& help,
+        const Labels& = Labels()) noexcept;
+    Histogram& histogram(
+        const std::string& name,
+        const std::string& help,
+        const std::vector<double>& bounds,
+        const Labels& = Labels()) noexcept;
+
+    // Prometheus text exposition format
+    std::string serialize() const noexcept;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> _p;
+};
+
+}
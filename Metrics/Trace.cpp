@@ -0,0 +1,197 @@
+#include "Trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <set>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+
+namespace metrics::trace {
+
+namespace details {
+std::atomic<bool> enabled = false;
+}
+
+namespace {
+
+const char *const TraceFileEnv = "WEBRTSP_TRACE_FILE";
+
+struct State
+{
+    std::mutex mutex;
+    FILE* file = nullptr;
+    bool firstEvent = true;
+    std::set<size_t> namedTracks;
+};
+
+State& GetState()
+{
+    static State state;
+    return state;
+}
+
+std::string Escape(const std::string& in)
+{
+    std::string out;
+    out.reserve(in.size());
+    for(char c: in) {
+        if(c == '"' || c == '\\')
+            out += '\\';
+        if(static_cast<unsigned char>(c) >= 0x20)
+            out += c;
+    }
+
+    return out;
+}
+
+long long Microseconds(Clock::time_point timePoint)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        timePoint.time_since_epoch()).count();
+}
+
+size_t TrackId(const std::string& sessionLogId)
+{
+    // keep it in range of JSON safe integers
+    return std::hash<std::string>()(sessionLogId) & 0x7FFFFFFF;
+}
+
+// should be called with locked mutex
+void WriteEvent(State& state, const std::string& event)
+{
+    if(!state.file)
+        return;
+
+    if(!state.firstEvent)
+        fputs(",\n", state.file);
+
+    fputs(event.c_str(), state.file);
+    state.firstEvent = false;
+}
+
+void WriteEvent(
+    char phase,
+    const char* name,
+    const std::string& sessionLogId,
+    const std::string& mediaSession,
+    Clock::time_point begin,
+    Clock::time_point end)
+{
+    const std::string pid = std::to_string(getpid());
+    const size_t trackId = TrackId(sessionLogId);
+    const std::string tid = std::to_string(trackId);
+
+    std::string event =
+        "{\"name\":\"" + Escape(name) + "\",\"cat\":\"webrtsp\",\"ph\":\"" + phase + "\"," +
+        "\"ts\":" + std::to_string(Microseconds(begin)) + ",";
+    if(phase == 'X')
+        event += "\"dur\":" + std::to_string(Microseconds(end) - Microseconds(begin)) + ",";
+    else
+        event += "\"s\":\"t\",";
+    event += "\"pid\":" + pid + ",\"tid\":" + tid + ",";
+    event += "\"args\":{\"session\":\"" + Escape(sessionLogId) + "\"";
+    if(!mediaSession.empty())
+        event += ",\"mediaSession\":\"" + Escape(mediaSession) + "\"";
+    event += "}}";
+
+    State& state = GetState();
+    std::lock_guard lock(state.mutex);
+
+    if(state.namedTracks.insert(trackId).second) {
+        WriteEvent(
+            state,
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid + "," +
+            "\"args\":{\"name\":\"session " + Escape(sessionLogId) + "\"}}");
+    }
+
+    WriteEvent(state, event);
+}
+
+struct AutoStart
+{
+    AutoStart()
+    {
+        // to be sure state outlives autoStart
+        GetState();
+
+        if(const char* path = getenv(TraceFileEnv))
+            Start(path);
+    }
+    ~AutoStart()
+    {
+        Stop();
+    }
+} autoStart;
+
+}
+
+bool Start(const std::string& path) noexcept
+{
+    State& state = GetState();
+    std::lock_guard lock(state.mutex);
+
+    if(state.file)
+        return false;
+
+    state.file = fopen(path.c_str(), "w");
+    if(!state.file)
+        return false;
+
+    fputs("[\n", state.file);
+    state.firstEvent = true;
+    state.namedTracks.clear();
+
+    details::enabled.store(true, std::memory_order_relaxed);
+
+    return true;
+}
+
+void Stop() noexcept
+{
+    State& state = GetState();
+    std::lock_guard lock(state.mutex);
+
+    details::enabled.store(false, std::memory_order_relaxed);
+
+    if(!state.file)
+        return;
+
+    fputs("\n]\n", state.file);
+    fclose(state.file);
+    state.file = nullptr;
+}
+
+void Complete(
+    const char* name,
+    const std::string& sessionLogId,
+    const std::string& mediaSession,
+    Clock::time_point begin,
+    Clock::time_point end) noexcept
+{
+    if(!Enabled())
+        return;
+
+    WriteEvent('X', name, sessionLogId, mediaSession, begin, end);
+}
+
+void Instant(
+    const char* name,
+    const std::string& sessionLogId,
+    const std::string& mediaSession) noexcept
+{
+    if(!Enabled())
+        return;
+
+    const Clock::time_point now = Clock::now();
+    WriteEvent('i', name, sessionLogId, mediaSession, now, now);
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+
+// Chrome trace event format spans, viewable in chrome://tracing or ui.perfetto.dev.
+// Every RTSP session gets its own track, so whole signalling exchange can be seen at once.
+namespace metrics::trace {
+
+typedef std::chrono::steady_clock Clock;
+
+namespace details {
+extern std::atomic<bool> enabled;
+}
+
+inline bool Enabled() noexcept
+    { return details::enabled.load(std::memory_order_relaxed); }
+
+// Tracing is also started on process start if WEBRTSP_TRACE_FILE environment variable is set
+bool Start(const std::string& path) noexcept;
+void Stop() noexcept;
+
+// name is expected to be string literal
+void Complete(
+    const char* name,
+    const std::string& sessionLogId,
+    const std::string& mediaSession,
+    Clock::time_point begin,
+    Clock::time_point end) noexcept;
+void Instant(
+    const char* name,
+    const std::string& sessionLogId,
+    const std::string& mediaSession = std::string()) noexcept;
+
+// does nothing except single atomic load if tracing is disabled
+class Span
+{
+public:
+    Span(
+        const char* name,
+        const std::string& sessionLogId,
+        const std::string& mediaSession = std::string()) noexcept :
+        _name(name)
+    {
+        if(Enabled()) {
+            _sessionLogId = sessionLogId;
+            _mediaSession = mediaSession;
+            _begin = Clock::now();
+        }
+    }
+    ~Span()
+    {
+        if(_begin != Clock::time_point())
+            Complete(_name, _sessionLogId, _mediaSession, _begin, Clock::now());
+    }
+
+    Span(const Span&) = delete;
+    Span& operator = (const Span&) = delete;
+
+    void setMediaSession(const std::string& mediaSession) noexcept
+        { if(_begin != Clock::time_point()) _mediaSession = mediaSession; }
+
+private:
+    const char *const _name;
+    std::string _sessionLogId;
+    std::string _mediaSession;
+    Clock::time_point _begin;
+};
+
+}
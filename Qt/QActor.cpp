@@ -15,8 +15,6 @@ struct GlibUnref {
         { g_main_context_unref(context); }
     void operator() (GMainLoop* loop)
         { g_main_loop_unref(loop); }
-    void operator() (GAsyncQueue* queue)
-        { g_async_queue_unref(queue); }
 };
 
 typedef
@@ -27,62 +25,120 @@ typedef
     std::unique_ptr<
         GMainLoop,
         GlibUnref> GMainLoopPtr;
-typedef
-    std::unique_ptr<
-        GAsyncQueue,
-        GlibUnref> GAsyncQueuePtr;
-
-struct Action {
-    QActor::Action action;
-};
 
-void OnEvent(GAsyncQueue* queue)
-{
-    while(gpointer item = g_async_queue_try_pop(queue)) {
-        std::unique_ptr<Action>(static_cast<Action*>(item))->action();
-    }
 }
 
-void ActorMain(
-    GMainContext* mainContext,
-    GMainLoop* mainLoop,
-    GAsyncQueue* queue,
-    EventSource2* notifier)
-{
-    g_main_context_push_thread_default(mainContext);
-
-    notifier->subscribe(std::bind(&OnEvent, queue));
+struct QActor::Private {
+    struct StubNode final: public Node
+    {
+        void run() override {}
+    };
 
-    g_main_loop_run(mainLoop);
+    Private();
+    ~Private();
 
-    g_main_context_pop_thread_default(mainContext);
-}
+    static void ActorMain(Private*);
 
-}
-
-struct QActor::Private {
-    Private();
+    // can be called from any thread
+    void push(Node*) noexcept;
+    // should be called from actor thread only
+    Node* pop() noexcept;
+    void onEvent() noexcept;
 
     GMainContextPtr mainContextPtr;
     GMainLoopPtr mainLoopPtr;
-    GAsyncQueuePtr queuePtr;
     EventSource2 notifier;
     QThread *const actorThread;
+
+    // intrusive MPSC queue (Dmitry Vyukov's one)
+    StubNode stub;
+    std::atomic<Node*> head; // producers side
+    Node* tail; // consumer side
+
+    // set by the first post after queue drain, so there is single wakeup per batch
+    std::atomic<bool> wakeupPending = false;
 };
 
 QActor::Private::Private() :
     mainContextPtr(g_main_context_new()),
     mainLoopPtr(g_main_loop_new(mainContextPtr.get(), FALSE)),
-    queuePtr(g_async_queue_new()),
     notifier(mainContextPtr.get()),
-    actorThread(
-        QThread::create(
-            ActorMain,
-            mainContextPtr.get(),
-            mainLoopPtr.get(),
-            queuePtr.get(),
-            &notifier))
+    actorThread(QThread::create(ActorMain, this)),
+    head(&stub),
+    tail(&stub)
+{
+}
+
+QActor::Private::~Private()
+{
+    // actions posted after actor stop are just dropped
+    while(Node* node = pop())
+        delete node;
+}
+
+void QActor::Private::ActorMain(Private* p)
+{
+    g_main_context_push_thread_default(p->mainContextPtr.get());
+
+    p->notifier.subscribe(std::bind(&Private::onEvent, p));
+
+    g_main_loop_run(p->mainLoopPtr.get());
+
+    g_main_context_pop_thread_default(p->mainContextPtr.get());
+}
+
+void QActor::Private::push(Node* node) noexcept
 {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* prev = head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+QActor::Node* QActor::Private::pop() noexcept
+{
+    Node* tail = this->tail;
+    Node* next = tail->next.load(std::memory_order_acquire);
+
+    if(tail == &stub) {
+        if(!next)
+            return nullptr;
+
+        this->tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if(next) {
+        this->tail = next;
+        return tail;
+    }
+
+    if(tail != head.load(std::memory_order_acquire)) {
+        // some producer is in the middle of push,
+        // it will post wakeup after finish
+        return nullptr;
+    }
+
+    push(&stub);
+
+    next = tail->next.load(std::memory_order_acquire);
+    if(next) {
+        this->tail = next;
+        return tail;
+    }
+
+    return nullptr;
+}
+
+void QActor::Private::onEvent() noexcept
+{
+    // reset before drain, so anything posted from now on will produce new wakeup
+    wakeupPending.store(false, std::memory_order_seq_cst);
+
+    while(Node* node = pop()) {
+        node->run();
+        delete node;
+    }
 }
 
 QActor::QActor(QObject* parent) :
@@ -107,20 +163,12 @@ QThread* QActor::actorThread() const noexcept
     return _p->actorThread;
 }
 
-void QActor::postAction(const Action& action)
+void QActor::post(Node* node) noexcept
 {
-    g_async_queue_push(
-        _p->queuePtr.get(),
-        new ::Action { action });
-    _p->notifier.postEvent();
-}
+    _p->push(node);
 
-void QActor::postAction(Action&& action)
-{
-    g_async_queue_push(
-        _p->queuePtr.get(),
-        new ::Action { std::move(action) });
-    _p->notifier.postEvent();
+    if(!_p->wakeupPending.exchange(true, std::memory_order_seq_cst))
+        _p->notifier.postEvent();
 }
 
 void QActor::sendAction(const Action& action)
@@ -131,17 +179,13 @@ void QActor::sendAction(const Action& action)
 
     std::unique_lock guardLock(guard);
 
-    g_async_queue_push(
-        _p->queuePtr.get(),
-        new ::Action {
-            [&guard, &conditional, &action, &handled] () {
-                std::unique_lock guardLock(guard);
-                action();
-                handled = true;
-                conditional.notify_one();
-            }
+    postAction(
+        [&guard, &conditional, &action, &handled] () {
+            std::unique_lock guardLock(guard);
+            action();
+            handled = true;
+            conditional.notify_one();
         });
-    _p->notifier.postEvent();
 
     conditional.wait(guardLock, [&handled] () { return handled; });
 }
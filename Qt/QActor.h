@@ -1,9 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <functional>
+#include <type_traits>
 
 #include <QObject>
+#include <QFuture>
+#include <QPromise>
 
 
 class QActor: public QObject
@@ -20,11 +24,69 @@ public:
     QThread* actorThread() const noexcept;
 
     typedef std::function<void ()> Action;
-    void postAction(const Action&);
-    void postAction(Action&&);
+
+    // accepts any callable, including move-only ones
+    template<typename Callable>
+    void postAction(Callable&&);
+    // blocks caller until action is executed
     void sendAction(const Action&);
+    // doesn't block caller. Use QFuture::then(context, ...) to get continuation on caller thread.
+    // Future is canceled if actor is destroyed before action execution.
+    template<typename Callable>
+    auto sendActionAsync(Callable&&) -> QFuture<std::invoke_result_t<std::decay_t<Callable>&>>;
 
 private:
+    // action is stored inside queue node, so every post costs exactly one allocation
+    struct Node
+    {
+        virtual ~Node() {}
+        virtual void run() = 0;
+
+        std::atomic<Node*> next = nullptr;
+    };
+
+    template<typename Callable>
+    struct CallableNode final: public Node
+    {
+        explicit CallableNode(Callable&& callable) :
+            callable(std::forward<Callable>(callable)) {}
+
+        void run() override
+            { callable(); }
+
+        std::decay_t<Callable> callable;
+    };
+
+    void post(Node*) noexcept;
+
     struct Private;
     std::unique_ptr<Private> _p;
 };
+
+template<typename Callable>
+void QActor::postAction(Callable&& callable)
+{
+    post(new CallableNode<Callable>(std::forward<Callable>(callable)));
+}
+
+template<typename Callable>
+auto QActor::sendActionAsync(Callable&& callable) -> QFuture<std::invoke_result_t<std::decay_t<Callable>&>>
+{
+    typedef std::invoke_result_t<std::decay_t<Callable>&> Result;
+
+    QPromise<Result> promise;
+    QFuture<Result> future = promise.future();
+    promise.start();
+
+    postAction(
+        [callable = std::forward<Callable>(callable), promise = std::move(promise)] () mutable {
+            if constexpr(std::is_void_v<Result>) {
+                callable();
+            } else {
+                promise.addResult(callable());
+            }
+            promise.finish();
+        });
+
+    return future;
+}
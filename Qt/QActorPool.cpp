@@ -0,0 +1,48 @@
+#include "QActorPool.h"
+
+#include <algorithm>
+
+#include <QThread>
+
+
+QActorPool::QActorPool(unsigned size, QObject* parent) :
+    QObject(parent)
+{
+    if(!size)
+        size = std::max(QThread::idealThreadCount(), 1);
+
+    _actors.reserve(size);
+    for(unsigned i = 0; i < size; ++i)
+        _actors.emplace_back(std::make_unique<QActor>());
+
+    _loads.resize(size, 0);
+}
+
+QActorPool::~QActorPool()
+{
+}
+
+unsigned QActorPool::size() const noexcept
+{
+    return _actors.size();
+}
+
+QActor* QActorPool::actor(unsigned index) const noexcept
+{
+    Q_ASSERT(index < _actors.size());
+    return _actors[index].get();
+}
+
+unsigned QActorPool::acquire() noexcept
+{
+    const unsigned index = std::min_element(_loads.begin(), _loads.end()) - _loads.begin();
+    ++_loads[index];
+
+    return index;
+}
+
+void QActorPool::release(unsigned index) noexcept
+{
+    Q_ASSERT(index < _loads.size() && _loads[index] > 0);
+    --_loads[index];
+}
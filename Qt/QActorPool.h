@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <QObject>
+
+#include "QActor.h"
+
+
+// Fixed set of actors. Every user (session) is expected to stick to the single actor
+// got from acquire() during whole lifetime, so order of its actions is preserved.
+class QActorPool: public QObject
+{
+    Q_OBJECT
+
+    QActorPool(QActorPool&) = delete;
+    QActorPool& operator = (QActorPool&) = delete;
+
+public:
+    // 0 - QThread::idealThreadCount()
+    explicit QActorPool(unsigned size = 0, QObject* parent = nullptr);
+    ~QActorPool();
+
+    unsigned size() const noexcept;
+    QActor* actor(unsigned index) const noexcept;
+
+    // returns index of the least loaded actor and increments its load.
+    // acquire/release should be called from the same thread
+    unsigned acquire() noexcept;
+    void release(unsigned index) noexcept;
+
+private:
+    std::vector<std::unique_ptr<QActor>> _actors;
+    std::vector<unsigned> _loads;
+};
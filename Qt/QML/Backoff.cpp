@@ -0,0 +1,24 @@
+#include "Backoff.h"
+
+#include <algorithm>
+
+#include <QRandomGenerator>
+
+
+using namespace webrtsp::qml;
+
+std::chrono::milliseconds Backoff::next() noexcept
+{
+    const unsigned attempt = _attempt++;
+    if(attempt == 0)
+        return std::chrono::milliseconds(0);
+
+    // shift is limited to not overflow on long outages
+    const std::chrono::milliseconds delay =
+        std::min(_max, std::chrono::milliseconds(_min.count() << std::min(attempt - 1, 16u)));
+
+    return std::chrono::milliseconds(
+        QRandomGenerator::global()->bounded(
+            static_cast<qint64>(delay.count() / 2),
+            static_cast<qint64>(delay.count() + 1)));
+}
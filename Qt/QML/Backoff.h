@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+
+
+namespace webrtsp::qml {
+
+// first retry is immediate,
+// then delay doubles on every attempt up to max, with random jitter in [delay / 2, delay]
+class Backoff
+{
+public:
+    Backoff(std::chrono::milliseconds min, std::chrono::milliseconds max) noexcept :
+        _min(min), _max(max) {}
+
+    std::chrono::milliseconds next() noexcept;
+    void reset() noexcept { _attempt = 0; }
+
+private:
+    const std::chrono::milliseconds _min;
+    const std::chrono::milliseconds _max;
+    unsigned _attempt = 0;
+};
+
+}
@@ -1,5 +1,7 @@
 #include "Connection.h"
 
+#include <algorithm>
+
 #include <QSslConfiguration>
 #include <QtWebSockets/QWebSocketHandshakeOptions>
 
@@ -15,8 +17,8 @@
 using namespace webrtsp::qml;
 
 enum {
-    RECONNECT_INTERVAL_MIN = 1, // seconds
-    RECONNECT_INTERVAL_MAX = 5, // seconds
+    RECONNECT_BACKOFF_MIN = 250, // ms
+    RECONNECT_BACKOFF_MAX = 10000, // ms
     PING_INTERVAL = 60, // seconds
     LONG_REQUEST_RESPONSE_TIMEOUT = 60, // seconds
 };
@@ -27,7 +29,10 @@ Connection::Connection(QObject* parent) noexcept :
         std::make_shared<WebRTCConfig>(),
         [this] (const rtsp::Request* request) { sendRequest(request); },
         [this] (const rtsp::Response* response) { sendResponse(response); }),
-    _stunServerUrl("stun://stun.cloudflare.com")
+    _stunServerUrl("stun://stun.cloudflare.com"),
+    _reconnectBackoff(
+        std::chrono::milliseconds(RECONNECT_BACKOFF_MIN),
+        std::chrono::milliseconds(RECONNECT_BACKOFF_MAX))
 {
     updateWebRTCConfig();
 
@@ -53,6 +58,20 @@ void Connection::unregisterClient(Client* client) noexcept
         }
     }
 
+    for(auto& pair: _pendingInfo) {
+        std::vector<Client*>& waiters = pair.second.waiters;
+        waiters.erase(std::remove(waiters.begin(), waiters.end(), client), waiters.end());
+    }
+
+    for(auto& pair: _pendingDescribes) {
+        for(PendingDescribe& part: pair.second) {
+            if(part.owner == client) {
+                // media session will be teardowned after response
+                part.owner = nullptr;
+            }
+        }
+    }
+
     for(auto it = _mediaSessions.begin(); it != _mediaSessions.end();) {
         if(it->second.owner == client) {
             requestTeardown(nullptr, it->second.encodedUri, it->first);
@@ -121,6 +140,9 @@ void Connection::close(bool reconnect) noexcept
         client->onDisconnected();
 
     _sentRequests.clear();
+    _pendingInfo.clear();
+    _aggregateDescribeRequest = nullptr;
+    _pendingDescribes.clear();
     _mediaSessions.clear();
 
     if(_webSocket) {
@@ -133,10 +155,8 @@ void Connection::close(bool reconnect) noexcept
     }
 
     if(_reconnect) {
-        const int delay = QRandomGenerator::global()->bounded(
-                RECONNECT_INTERVAL_MIN * 1000,
-                RECONNECT_INTERVAL_MAX * 1000);
-        qDebug(QmlClient) << "Scheduled reconnect in" << delay << "ms";
+        const std::chrono::milliseconds delay = _reconnectBackoff.next();
+        qDebug(QmlClient) << "Scheduled reconnect in" << delay.count() << "ms";
         _reconnectTimer.start(delay);
     } else {
         _reconnectTimer.stop();
@@ -151,6 +171,14 @@ void Connection::setServerUrl(const QUrl& url) noexcept
     close();
 
     _serverUrl = url;
+    _infoCache.clear();
+}
+
+void Connection::setInfoCacheTtl(int infoCacheTtl) noexcept
+{
+    _infoCacheTtl = infoCacheTtl;
+    if(_infoCacheTtl <= 0)
+        _infoCache.clear();
 }
 
 void Connection::setStunServerUrl(const QUrl& stunServerUrl) noexcept
@@ -275,6 +303,8 @@ void Connection::authorized() noexcept
 {
     _isOpen = true;
 
+    _reconnectBackoff.reset();
+
     _pingTimer.start();
 
     for(Client* client: _clients) {
@@ -376,62 +406,211 @@ bool Connection::handleResponse(
     if(auto it = _sentRequests.find(responsePtr->cseq); it != _sentRequests.end()) {
         Client* target = it->second.owner;
         _sentRequests.erase(it);
-        if(target) { // sender may not care about response
-            const bool handled = target->handleResponse(request, responsePtr);
-            if(handled &&
-                request.method == rtsp::Method::DESCRIBE &&
-                responsePtr->statusCode == rtsp::StatusCode::OK)
-            {
-                const rtsp::MediaSessionId mediaSession = rtsp::ResponseSession(*responsePtr);
-                Q_ASSERT(!mediaSession.empty());
-                if(!mediaSession.empty())
-                    _mediaSessions.emplace(mediaSession, MediaSessionData { request.uri, target });
-            }
-            return handled;
-        } else if(request.method == rtsp::Method::DESCRIBE &&
-            responsePtr->statusCode == rtsp::StatusCode::OK)
-        {
-            // it's highly possible target was destroyed before receive answer for DESCRIBE.
-            // have to force media session TEARDOWN
+
+        if(auto infoIt = _pendingInfo.find(responsePtr->cseq); infoIt != _pendingInfo.end()) {
+            PendingInfo pendingInfo = std::move(infoIt->second);
+            _pendingInfo.erase(infoIt);
+            return handleInfoResponse(std::move(pendingInfo), request, responsePtr);
+        }
+
+        if(auto describeIt = _pendingDescribes.find(responsePtr->cseq); describeIt != _pendingDescribes.end()) {
+            std::vector<PendingDescribe> parts = std::move(describeIt->second);
+            _pendingDescribes.erase(describeIt);
+            return handleAggregateDescribeResponse(std::move(parts), request, responsePtr);
+        }
+
+        if(request.method == rtsp::Method::DESCRIBE)
+            return handleDescribeResponse(target, request, responsePtr);
+        else if(target) // sender may not care about response
+            return target->handleResponse(request, responsePtr);
+        else
+            return true;
+    }
+
+    return false;
+}
+
+bool Connection::handleDescribeResponse(
+    Client* target,
+    const rtsp::Request& request,
+    std::unique_ptr<rtsp::Response>& responsePtr) noexcept
+{
+    if(target) {
+        const bool handled = target->handleResponse(request, responsePtr);
+        if(handled && responsePtr->statusCode == rtsp::StatusCode::OK) {
             const rtsp::MediaSessionId mediaSession = rtsp::ResponseSession(*responsePtr);
+            Q_ASSERT(!mediaSession.empty());
             if(!mediaSession.empty())
-                requestTeardown(nullptr, request.uri, mediaSession);
+                _mediaSessions.emplace(mediaSession, MediaSessionData { request.uri, target });
+        }
+        return handled;
+    } else if(responsePtr->statusCode == rtsp::StatusCode::OK) {
+        // it's highly possible target was destroyed before receive answer for DESCRIBE.
+        // have to force media session TEARDOWN
+        const rtsp::MediaSessionId mediaSession = rtsp::ResponseSession(*responsePtr);
+        if(!mediaSession.empty())
+            requestTeardown(nullptr, request.uri, mediaSession);
+    }
 
-            return true;
-        } else {
-            return true;
+    return true;
+}
+
+bool Connection::handleAggregateDescribeResponse(
+    std::vector<PendingDescribe>&& parts,
+    const rtsp::Request& request,
+    std::unique_ptr<rtsp::Response>& responsePtr) noexcept
+{
+    Q_ASSERT(!parts.empty());
+
+    // previous part owner could destroy other one while handling response
+    auto partOwner = [this] (const PendingDescribe& part) -> Client* {
+        return part.owner && _clients.count(part.owner) ? part.owner : nullptr;
+    };
+
+    if(rtsp::ResponseContentType(*responsePtr) != rtsp::MediaDescriptionsContentType) {
+        if(parts.size() == 1) // was sent as ordinary DESCRIBE
+            return handleDescribeResponse(partOwner(parts.front()), request, responsePtr);
+
+        if(responsePtr->statusCode == rtsp::StatusCode::OK)
+            return false;
+
+        // the whole request failed, so every part failed the same way
+        bool handled = true;
+        for(const PendingDescribe& part: parts) {
+            rtsp::Request partRequest = request;
+            partRequest.uri = part.encodedUri;
+
+            std::unique_ptr<rtsp::Response> partResponsePtr =
+                std::make_unique<rtsp::Response>(*responsePtr);
+            if(!handleDescribeResponse(partOwner(part), partRequest, partResponsePtr))
+                handled = false;
         }
+
+        return handled;
     }
 
-    return false;
+    rtsp::MediaDescriptions descriptions;
+    if(!rtsp::ParseMediaDescriptions(responsePtr->body, &descriptions) ||
+        descriptions.size() != parts.size())
+    {
+        return false;
+    }
+
+    bool handled = true;
+    for(size_t i = 0; i < parts.size(); ++i) {
+        const PendingDescribe& part = parts[i];
+        const rtsp::MediaDescription& description = descriptions[i];
+
+        if(description.uri != part.encodedUri)
+            return false;
+
+        rtsp::Request partRequest = request;
+        partRequest.uri = part.encodedUri;
+        partRequest.headerFields.erase(rtsp::ContentTypeFieldName);
+        partRequest.body.clear();
+
+        std::unique_ptr<rtsp::Response> partResponsePtr = std::make_unique<rtsp::Response>();
+        partResponsePtr->protocol = responsePtr->protocol;
+        partResponsePtr->statusCode = description.statusCode;
+        partResponsePtr->cseq = responsePtr->cseq;
+        if(description.statusCode == rtsp::StatusCode::OK) {
+            partResponsePtr->reasonPhrase = responsePtr->reasonPhrase;
+            rtsp::SetResponseSession(partResponsePtr.get(), description.session);
+            rtsp::SetContentType(partResponsePtr.get(), rtsp::SdpContentType);
+            partResponsePtr->body = description.sdp;
+        }
+
+        if(!handleDescribeResponse(partOwner(part), partRequest, partResponsePtr))
+            handled = false;
+    }
+
+    return handled;
 }
 
-rtsp::CSeq Connection::requestOptions(Client* source, const std::string& encodedUri) noexcept
+rtsp::CSeq Connection::requestInfo(
+    Client* source,
+    rtsp::Method method,
+    const std::string& encodedUri) noexcept
 {
     if(!_isOpen) {
         Q_ASSERT(false);
         return rtsp::InvalidCSeq;
     }
 
-    const rtsp::CSeq cseq = rtsp::Session::requestOptions(encodedUri);
+    InfoKey key(method, encodedUri);
+
+    if(auto it = _infoCache.find(key); it != _infoCache.end()) {
+        if(!it->second.expiresAt.hasExpired()) {
+            QMetaObject::invokeMethod(
+                this,
+                [this, source, cachedInfo = it->second] () {
+                    // client could be destroyed or connection reopened meanwhile
+                    if(!_isOpen || !_clients.count(source))
+                        return;
+
+                    std::unique_ptr<rtsp::Response> responsePtr =
+                        std::make_unique<rtsp::Response>(*cachedInfo.response);
+                    if(!source->handleResponse(*cachedInfo.request, responsePtr))
+                        close(true);
+                },
+                Qt::QueuedConnection);
+
+            return it->second.response->cseq;
+        }
 
-    _sentRequests.emplace(cseq, RequestData { source });
+        _infoCache.erase(it);
+    }
+
+    for(auto& pair: _pendingInfo) {
+        if(pair.second.key == key) {
+            pair.second.waiters.push_back(source);
+            return pair.first;
+        }
+    }
+
+    const rtsp::CSeq cseq = method == rtsp::Method::OPTIONS ?
+        rtsp::Session::requestOptions(encodedUri) :
+        rtsp::Session::requestList(encodedUri);
+
+    _sentRequests.emplace(cseq, RequestData { nullptr });
+    _pendingInfo.emplace(cseq, PendingInfo { std::move(key), { source } });
 
     return cseq;
 }
 
-rtsp::CSeq Connection::requestList(Client* source, const std::string& encodedUri) noexcept
+bool Connection::handleInfoResponse(
+    PendingInfo&& pendingInfo,
+    const rtsp::Request& request,
+    std::unique_ptr<rtsp::Response>& responsePtr) noexcept
 {
-    if(!_isOpen) {
-        Q_ASSERT(false);
-        return rtsp::InvalidCSeq;
+    if(_infoCacheTtl > 0 && responsePtr->statusCode == rtsp::StatusCode::OK) {
+        _infoCache[pendingInfo.key] = CachedInfo {
+            std::make_shared<rtsp::Request>(request),
+            std::make_shared<rtsp::Response>(*responsePtr),
+            QDeadlineTimer(_infoCacheTtl * 1000) };
     }
 
-    const rtsp::CSeq cseq = rtsp::Session::requestList(encodedUri);
+    bool handled = true;
+    for(Client* waiter: pendingInfo.waiters) {
+        // previous waiter could destroy other one while handling response
+        if(!_clients.count(waiter))
+            continue;
 
-    _sentRequests.emplace(cseq, RequestData { source });
+        if(!waiter->handleResponse(request, responsePtr))
+            handled = false;
+    }
 
-    return cseq;
+    return handled;
+}
+
+rtsp::CSeq Connection::requestOptions(Client* source, const std::string& encodedUri) noexcept
+{
+    return requestInfo(source, rtsp::Method::OPTIONS, encodedUri);
+}
+
+rtsp::CSeq Connection::requestList(Client* source, const std::string& encodedUri) noexcept
+{
+    return requestInfo(source, rtsp::Method::LIST, encodedUri);
 }
 
 rtsp::CSeq Connection::requestDescribe(Client* source, const std::string& encodedUri) noexcept
@@ -441,6 +620,25 @@ rtsp::CSeq Connection::requestDescribe(Client* source, const std::string& encode
         return rtsp::InvalidCSeq;
     }
 
+    if(_aggregateDescribe) {
+        if(!_aggregateDescribeRequest) {
+            // request is sent after all clients had a chance to join it
+            _aggregateDescribeRequest = createRequest(rtsp::Method::DESCRIBE, rtsp::WildcardUri);
+            _sentRequests.emplace(
+                _aggregateDescribeRequest->cseq,
+                RequestData { nullptr, QDeadlineTimer(LONG_REQUEST_RESPONSE_TIMEOUT * 1000) });
+            QMetaObject::invokeMethod(
+                this,
+                &Connection::sendAggregateDescribe,
+                Qt::QueuedConnection);
+        }
+
+        const rtsp::CSeq cseq = _aggregateDescribeRequest->cseq;
+        _pendingDescribes[cseq].push_back(PendingDescribe { source, encodedUri });
+
+        return cseq;
+    }
+
     const rtsp::CSeq cseq = rtsp::Session::requestDescribe(encodedUri);
 
     _sentRequests.emplace(
@@ -450,6 +648,39 @@ rtsp::CSeq Connection::requestDescribe(Client* source, const std::string& encode
     return cseq;
 }
 
+void Connection::sendAggregateDescribe() noexcept
+{
+    rtsp::Request* request = _aggregateDescribeRequest;
+    _aggregateDescribeRequest = nullptr;
+
+    // connection could be closed meanwhile
+    if(!request)
+        return;
+
+    auto it = _pendingDescribes.find(request->cseq);
+    if(it == _pendingDescribes.end()) {
+        Q_ASSERT(false);
+        return;
+    }
+
+    const std::vector<PendingDescribe>& parts = it->second;
+    if(parts.size() == 1) {
+        request->uri = parts.front().encodedUri;
+    } else {
+        std::vector<std::string> uris;
+        uris.reserve(parts.size());
+        for(const PendingDescribe& part: parts)
+            uris.push_back(part.encodedUri);
+
+        rtsp::SetContentType(request, rtsp::UriListContentType);
+        rtsp::Serialize(uris, &request->body);
+    }
+
+    qDebug(QmlClient) << "Sending DESCRIBE for" << parts.size() << "uri(s)";
+
+    rtsp::Session::sendRequest(*request);
+}
+
 rtsp::CSeq Connection::requestPlay(
     Client* source,
     const std::string& encodedUri,
@@ -8,6 +8,7 @@
 
 #include "RtspSession/Session.h"
 
+#include "Backoff.h"
 #include "UriInfo.h"
 #include "Player.h"
 
@@ -34,6 +35,26 @@ public:
         Client* owner;
     };
 
+    // OPTIONS and LIST results are shared between clients requesting the same uri
+    typedef std::pair<rtsp::Method, std::string> InfoKey; // method, encoded uri
+
+    struct CachedInfo {
+        std::shared_ptr<const rtsp::Request> request;
+        std::shared_ptr<const rtsp::Response> response;
+        QDeadlineTimer expiresAt;
+    };
+
+    struct PendingInfo {
+        InfoKey key;
+        std::vector<Client*> waiters;
+    };
+
+    // part of aggregate DESCRIBE, in the same order as uri in request
+    struct PendingDescribe {
+        Client* owner;
+        std::string encodedUri;
+    };
+
 public:
     Q_PROPERTY(QUrl serverUrl MEMBER _serverUrl WRITE setServerUrl)
     Q_PROPERTY(QUrl stunServerUrl MEMBER _stunServerUrl WRITE setStunServerUrl)
@@ -42,6 +63,15 @@ public:
     Q_PROPERTY(bool verifyCert MEMBER _verifyCert WRITE setVerifyCert)
     Q_PROPERTY(QString authToken MEMBER _authToken WRITE setAuthToken)
     Q_PROPERTY(bool isOpen READ isOpen)
+    // defaults for players created after change.
+    // Jitter buffer latency in ms, -1 - webrtcbin default
+    Q_PROPERTY(int latency MEMBER _latency WRITE setLatency)
+    Q_PROPERTY(bool adaptiveLatency MEMBER _adaptiveLatency WRITE setAdaptiveLatency)
+    // seconds OPTIONS and LIST results are reused for, 0 - disable cache
+    Q_PROPERTY(int infoCacheTtl MEMBER _infoCacheTtl WRITE setInfoCacheTtl)
+    // DESCRIBE requests made during the same event loop iteration are sent as single request.
+    // Requires server supporting aggregate DESCRIBE
+    Q_PROPERTY(bool aggregateDescribe MEMBER _aggregateDescribe WRITE setAggregateDescribe)
 
     explicit Connection(QObject* parent = nullptr) noexcept;
 
@@ -53,7 +83,14 @@ public:
 
     void setOrigin(const QString& origin) noexcept { _origin = origin; }
     void setVerifyCert(bool verifyCert) noexcept { _verifyCert = verifyCert; }
-    void setAuthToken(const QString& authToken) noexcept { _authToken = authToken; }
+    void setAuthToken(const QString& authToken) noexcept { _authToken = authToken; _infoCache.clear(); }
+    void setLatency(int latency) noexcept { _latency = latency; }
+    void setAdaptiveLatency(bool adaptiveLatency) noexcept { _adaptiveLatency = adaptiveLatency; }
+    void setInfoCacheTtl(int infoCacheTtl) noexcept;
+    void setAggregateDescribe(bool aggregateDescribe) noexcept { _aggregateDescribe = aggregateDescribe; }
+
+    int latency() const noexcept { return _latency; }
+    bool adaptiveLatency() const noexcept { return _adaptiveLatency; }
 
     Q_INVOKABLE bool isOpen() const noexcept { return _isOpen; }
 
@@ -63,8 +100,11 @@ public:
     Q_INVOKABLE UriInfo* uriInfo(const QString& uri);
     Q_INVOKABLE Player* player(const QString& uri, QQuickItem* view);
 
+    // could return CSeq shared with other clients or CSeq of cached response,
+    // response is always delivered asynchronously
     rtsp::CSeq requestOptions(Client* source, const std::string& encodedUri) noexcept;
     rtsp::CSeq requestList(Client* source, const std::string& encodedUri) noexcept;
+    // could return CSeq shared with other clients if aggregateDescribe is enabled
     rtsp::CSeq requestDescribe(Client* source, const std::string& encodedUri) noexcept;
     rtsp::CSeq requestPlay(
         Client* source,
@@ -106,6 +146,22 @@ private:
     void registerClient(Client*) noexcept;
     void unregisterClient(Client*) noexcept;
 
+    rtsp::CSeq requestInfo(Client* source, rtsp::Method, const std::string& encodedUri) noexcept;
+    bool handleInfoResponse(
+        PendingInfo&&,
+        const rtsp::Request&,
+        std::unique_ptr<rtsp::Response>&) noexcept;
+
+    void sendAggregateDescribe() noexcept;
+    bool handleAggregateDescribeResponse(
+        std::vector<PendingDescribe>&&,
+        const rtsp::Request&,
+        std::unique_ptr<rtsp::Response>&) noexcept;
+    bool handleDescribeResponse(
+        Client* target,
+        const rtsp::Request&,
+        std::unique_ptr<rtsp::Response>&) noexcept;
+
     void sendRequest(const rtsp::Request*) noexcept;
     void sendResponse(const rtsp::Response*) noexcept;
 
@@ -131,6 +187,10 @@ private:
     QString _origin;
     QString _authToken;
     bool _verifyCert = true;
+    int _latency = -1;
+    bool _adaptiveLatency = false;
+    int _infoCacheTtl = 30;
+    bool _aggregateDescribe = false;
     bool _reconnect = false;
     QWebSocket* _webSocket = nullptr;
     bool _isOpen = false;
@@ -140,9 +200,14 @@ private:
     std::set<Client*> _clients;
     std::map<rtsp::CSeq, RequestData> _sentRequests;
     std::map<rtsp::MediaSessionId, MediaSessionData> _mediaSessions;
+    std::map<InfoKey, CachedInfo> _infoCache;
+    std::map<rtsp::CSeq, PendingInfo> _pendingInfo;
+    rtsp::Request* _aggregateDescribeRequest = nullptr; // collecting uris, not sent yet
+    std::map<rtsp::CSeq, std::vector<PendingDescribe>> _pendingDescribes;
 
     QTimer _pingTimer;
     QTimer _reconnectTimer;
+    Backoff _reconnectBackoff;
 
     friend ConnectionClient;
 };
@@ -1,14 +1,257 @@
 #include "Peer.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 #include <gst/gst.h>
 #include <gst/pbutils/pbutils.h>
-#include <gst/webrtc/webrtc_fwd.h>
+#include <gst/webrtc/webrtc.h>
 
 #include <CxxPtr/GstWebRtcPtr.h>
 
 
 using namespace webrtsp::qml;
 
+namespace {
+
+enum {
+    CATCH_UP_THRESHOLD = 300, // ms
+    CAUGHT_UP_LAG = 50, // ms
+    CATCH_UP_MAX_DURATION = 3000, // ms
+    LAG_REPORT_INTERVAL = 500, // ms
+    LAG_REPORT_STEP = 20, // ms
+
+    STATS_INTERVAL = 2, // seconds
+    MIN_ADAPTIVE_LATENCY = 30, // ms
+    MAX_ADAPTIVE_LATENCY = 1500, // ms
+    JITTER_LATENCY_FACTOR = 4,
+    LOSS_LATENCY_MARGIN = 150, // ms, time for retransmission of lost packets
+    LOSS_THRESHOLD = 5, // per mille
+    LATENCY_CHANGE_STEP = 10, // ms
+
+    KEY_UNIT_REQUEST_INTERVAL = 1000, // ms
+};
+
+// decoders drop frames on QoS events from sink, frame threading is avoided since it adds frames of delay
+const gchar *const LowLatencyH264Decoder = "avdec_h264 thread-type=slice qos=true";
+const gchar *const LowLatencyH265Decoder = "avdec_h265 thread-type=slice qos=true";
+const gchar *const LowLatencyVp8Decoder = "vp8dec qos=true";
+const gchar *const LowLatencyQueue = "queue leaky=downstream max-size-buffers=2 max-size-bytes=0 max-size-time=0";
+const gchar *const LowLatencySink = "qml6glsink name=qmlsink sync=true qos=true max-lateness=20000000";
+
+}
+
+struct Peer::SuspendProbe
+{
+    Peer *const owner;
+    GstPad *const depaySrcPad; // owned by decode bin, can be null
+    bool suspended = false;
+};
+
+struct Peer::KeyFrameWait
+{
+    const bool postCanPlay;
+    const bool requestKeyFrame;
+    gint64 requestedAt = 0;
+};
+
+struct Peer::LagProbe
+{
+    Peer *const owner;
+
+    bool catchingUp = false;
+    bool catchUpFailed = false;
+    GstClockTime catchUpStartedAt = 0;
+    GstClockTimeDiff catchUpLag = 0;
+    unsigned droppedFrames = 0;
+
+    GstClockTimeDiff reportedLag = 0;
+    GstClockTime reportedAt = 0;
+};
+
+// stats are delivered on webrtcbin thread, so it's shared with promise callback
+struct Peer::LatencyControl
+{
+    LatencyControl(GstElement* rtcbin, guint latency) :
+        rtcbin(GST_ELEMENT(gst_object_ref(rtcbin))), latency(latency) {}
+    ~LatencyControl()
+        { gst_object_unref(rtcbin); }
+
+    void update(const GstStructure* stats) noexcept;
+
+    GstElement *const rtcbin;
+    std::atomic<bool> statsPending = false;
+
+    guint latency;
+    bool hasCounters = false;
+    guint64 packetsLost = 0;
+    guint64 packetsReceived = 0;
+};
+
+void Peer::LatencyControl::update(const GstStructure* stats) noexcept
+{
+    struct Totals {
+        gdouble jitter = 0; // seconds
+        guint64 packetsLost = 0;
+        guint64 packetsReceived = 0;
+    } totals;
+
+    gst_structure_foreach(
+        stats,
+        [] (GQuark, const GValue* value, gpointer userData) -> gboolean {
+            if(!GST_VALUE_HOLDS_STRUCTURE(value))
+                return TRUE;
+
+            const GstStructure* stat = gst_value_get_structure(value);
+            GstWebRTCStatsType type;
+            if(!gst_structure_get(stat, "type", GST_TYPE_WEBRTC_STATS_TYPE, &type, nullptr) ||
+                type != GST_WEBRTC_STATS_INBOUND_RTP)
+            {
+                return TRUE;
+            }
+
+            Totals* totals = static_cast<Totals*>(userData);
+
+            gdouble jitter = 0;
+            if(gst_structure_get_double(stat, "jitter", &jitter))
+                totals->jitter = std::max(totals->jitter, jitter);
+
+            gint64 packetsLost = 0;
+            if(gst_structure_get_int64(stat, "packets-lost", &packetsLost) && packetsLost > 0)
+                totals->packetsLost += packetsLost;
+
+            guint64 packetsReceived = 0;
+            if(gst_structure_get_uint64(stat, "packets-received", &packetsReceived))
+                totals->packetsReceived += packetsReceived;
+
+            return TRUE;
+        },
+        &totals);
+
+    const guint64 lost =
+        hasCounters && totals.packetsLost > packetsLost ? totals.packetsLost - packetsLost : 0;
+    const guint64 received =
+        hasCounters && totals.packetsReceived > packetsReceived ? totals.packetsReceived - packetsReceived : 0;
+    hasCounters = true;
+    packetsLost = totals.packetsLost;
+    packetsReceived = totals.packetsReceived;
+
+    guint target = MIN_ADAPTIVE_LATENCY + static_cast<guint>(JITTER_LATENCY_FACTOR * totals.jitter * 1000);
+    if(lost + received > 0 && lost * 1000 / (lost + received) >= LOSS_THRESHOLD)
+        target += LOSS_LATENCY_MARGIN;
+    target = std::clamp<guint>(target, MIN_ADAPTIVE_LATENCY, MAX_ADAPTIVE_LATENCY);
+
+    // grow at once to stop stuttering, shrink slowly to not oscillate on jitter spikes
+    guint newLatency = latency;
+    if(target > latency)
+        newLatency = target;
+    else if(target * 5 < latency * 4)
+        newLatency = latency - (latency - target) / 4;
+
+    if(newLatency + LATENCY_CHANGE_STEP > latency && newLatency < latency + LATENCY_CHANGE_STEP)
+        return;
+
+    latency = newLatency;
+    g_object_set(rtcbin, "latency", latency, nullptr);
+
+    GstStructure* structure = gst_structure_new("latency", "latency", G_TYPE_UINT, latency, nullptr);
+    gst_element_post_message(rtcbin, gst_message_new_application(GST_OBJECT(rtcbin), structure));
+}
+
+Peer::Peer(
+    QQuickItem* view,
+    const WebRTCConfigPtr& webRTCConfig,
+    bool lowLatency,
+    int latency,
+    bool adaptiveLatency) noexcept :
+    GstWebRTCPeer(Role::Viewer),
+    _view(view),
+    _webRTCConfig(webRTCConfig),
+    _lowLatency(lowLatency),
+    _latency(latency),
+    _adaptiveLatency(adaptiveLatency)
+{
+}
+
+Peer::~Peer() noexcept
+{
+    if(_statsSourcePtr)
+        g_source_destroy(_statsSourcePtr.get());
+}
+
+void Peer::setLatency(int latency, bool adaptive) noexcept
+{
+    _latency = latency;
+    _adaptiveLatency = adaptive;
+
+    applyLatency();
+}
+
+void Peer::applyLatency() noexcept
+{
+    if(!_rtcbin)
+        return;
+
+    if(_latency >= 0)
+        g_object_set(_rtcbin, "latency", static_cast<guint>(_latency), nullptr);
+
+    guint latency = 0;
+    g_object_get(_rtcbin, "latency", &latency, nullptr);
+    emit latencyChanged(static_cast<int>(latency));
+
+    if(!_adaptiveLatency) {
+        if(_statsSourcePtr) {
+            g_source_destroy(_statsSourcePtr.get());
+            _statsSourcePtr.reset();
+        }
+        _latencyControl.reset();
+        return;
+    }
+
+    _latencyControl = std::make_shared<LatencyControl>(_rtcbin, latency);
+
+    if(_statsSourcePtr)
+        return;
+
+    _statsSourcePtr.reset(g_timeout_source_new_seconds(STATS_INTERVAL));
+    g_source_set_callback(
+        _statsSourcePtr.get(),
+        [] (gpointer userData) -> gboolean {
+            static_cast<Peer*>(userData)->requestStats();
+            return G_SOURCE_CONTINUE;
+        },
+        this,
+        nullptr);
+    g_source_attach(_statsSourcePtr.get(), g_main_context_get_thread_default());
+}
+
+void Peer::requestStats() noexcept
+{
+    if(!_latencyControl || _latencyControl->statsPending.exchange(true))
+        return;
+
+    GstPromise* promise = gst_promise_new_with_change_func(
+        [] (GstPromise* promise, gpointer userData) {
+            std::shared_ptr<LatencyControl> control =
+                static_cast<std::weak_ptr<LatencyControl>*>(userData)->lock();
+            if(!control)
+                return;
+
+            if(gst_promise_wait(promise) == GST_PROMISE_RESULT_REPLIED) {
+                if(const GstStructure* stats = gst_promise_get_reply(promise))
+                    control->update(stats);
+            }
+
+            control->statsPending = false;
+        },
+        new std::weak_ptr<LatencyControl>(_latencyControl),
+        [] (gpointer userData) {
+            delete static_cast<std::weak_ptr<LatencyControl>*>(userData);
+        });
+    g_signal_emit_by_name(_rtcbin, "get-stats", nullptr, promise);
+    gst_promise_unref(promise);
+}
+
 void Peer::prepare() noexcept
 {
     GstWebRTCPeer::prepare(
@@ -25,6 +268,70 @@ void Peer::prepare() noexcept
         std::string());
 }
 
+// drops delta frames until key frame,
+// optionally requesting key frame from streamer instead of waiting for next GOP
+void Peer::waitKeyFrame(GstPad* depaySrcPad, bool postCanPlay, bool requestKeyFrame)
+{
+    gst_pad_add_probe(
+        depaySrcPad,
+        GST_PAD_PROBE_TYPE_BUFFER,
+        [] (GstPad* pad, GstPadProbeInfo* info, gpointer userData) -> GstPadProbeReturn {
+            GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+            KeyFrameWait* wait = static_cast<KeyFrameWait*>(userData);
+
+            if(GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+                const gint64 now = g_get_monotonic_time();
+                if(wait->requestKeyFrame &&
+                    (!wait->requestedAt || now - wait->requestedAt >= KEY_UNIT_REQUEST_INTERVAL * 1000))
+                {
+                    wait->requestedAt = now;
+                    Peer::requestKeyUnit(pad);
+                }
+                return GST_PAD_PROBE_DROP;
+            } else {
+                if(wait->postCanPlay)
+                    Peer::postCanPlay(GST_PAD_PARENT(pad));
+                return GST_PAD_PROBE_REMOVE;
+            }
+        },
+        new KeyFrameWait { postCanPlay, requestKeyFrame },
+        [] (gpointer userData) {
+            delete static_cast<KeyFrameWait*>(userData);
+        });
+}
+
+// will be called from streaming thread.
+// RTP is dropped before depayloader, so decoder is idle while webrtcbin keeps ICE/DTLS/RTCP alive
+GstPadProbeReturn Peer::onDecodeBinRtp(GstPad*, GstPadProbeInfo*, gpointer userData)
+{
+    SuspendProbe* probe = static_cast<SuspendProbe*>(userData);
+
+    if(probe->owner->_decodeSuspended) {
+        probe->suspended = true;
+        return GST_PAD_PROBE_DROP;
+    }
+
+    if(probe->suspended) {
+        probe->suspended = false;
+        if(probe->depaySrcPad)
+            // streamer GOP can be long, so don't leave resumed view frozen until next key frame
+            Peer::waitKeyFrame(probe->depaySrcPad, false, true);
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+// will be called from streaming thread
+void Peer::requestKeyUnit(GstPad* depaySrcPad)
+{
+    // rtpsession turns upstream GstForceKeyUnit into PLI/FIR
+    GstStructure* structure = gst_structure_new(
+        "GstForceKeyUnit",
+        "all-headers", G_TYPE_BOOLEAN, TRUE,
+        nullptr);
+    gst_pad_send_event(depaySrcPad, gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM, structure));
+}
+
 // will be called from streaming thread
 void Peer::postCanPlay(GstElement* element)
 {
@@ -35,6 +342,88 @@ void Peer::postCanPlay(GstElement* element)
     gst_bus_post(bus, message);
 }
 
+// will be called from streaming thread
+GstPadProbeReturn Peer::onSinkBuffer(GstPad* pad, GstPadProbeInfo* info, gpointer userData)
+{
+    LagProbe* probe = static_cast<LagProbe*>(userData);
+    GstElement* sink = GST_PAD_PARENT(pad);
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+
+    if(!GST_BUFFER_PTS_IS_VALID(buffer))
+        return GST_PAD_PROBE_OK;
+
+    GstClockTime bufferTime = GST_CLOCK_TIME_NONE;
+    if(GstEvent* segmentEvent = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0)) {
+        const GstSegment* segment = nullptr;
+        gst_event_parse_segment(segmentEvent, &segment);
+        bufferTime = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+        gst_event_unref(segmentEvent);
+    }
+
+    GstClock* clock = gst_element_get_clock(sink);
+    if(!clock || !GST_CLOCK_TIME_IS_VALID(bufferTime)) {
+        if(clock)
+            gst_object_unref(clock);
+        return GST_PAD_PROBE_OK;
+    }
+
+    const GstClockTime now = gst_clock_get_time(clock) - gst_element_get_base_time(sink);
+    gst_object_unref(clock);
+
+    GstClockTime latency = gst_pipeline_get_latency(GST_PIPELINE(probe->owner->pipeline()));
+    if(!GST_CLOCK_TIME_IS_VALID(latency))
+        latency = 0;
+
+    const GstClockTimeDiff lag = std::max<GstClockTimeDiff>(GST_CLOCK_DIFF(bufferTime + latency, now), 0);
+
+    if(lag < CATCH_UP_THRESHOLD * GST_MSECOND)
+        probe->catchUpFailed = false;
+
+    if(!probe->catchingUp && !probe->catchUpFailed &&
+        probe->owner->_lowLatency && lag > CATCH_UP_THRESHOLD * GST_MSECOND)
+    {
+        probe->catchingUp = true;
+        probe->catchUpStartedAt = now;
+        probe->catchUpLag = lag;
+        probe->droppedFrames = 0;
+    }
+
+    if(probe->catchingUp) {
+        const bool timedOut = now - probe->catchUpStartedAt > CATCH_UP_MAX_DURATION * GST_MSECOND;
+        if(lag > CAUGHT_UP_LAG * GST_MSECOND && !timedOut) {
+            ++probe->droppedFrames;
+            return GST_PAD_PROBE_DROP;
+        }
+
+        // lag which doesn't go away with dropped frames is not caused by backlog,
+        // so don't drop everything until it will disappear by itself
+        probe->catchingUp = false;
+        probe->catchUpFailed = timedOut;
+
+        GstStructure* structure = gst_structure_new(
+            "caught-up",
+            "skipped", G_TYPE_INT64, static_cast<gint64>((probe->catchUpLag - lag) / GST_MSECOND),
+            "dropped", G_TYPE_UINT, probe->droppedFrames,
+            nullptr);
+        gst_element_post_message(sink, gst_message_new_application(GST_OBJECT(sink), structure));
+    }
+
+    if(std::abs(lag - probe->reportedLag) >= LAG_REPORT_STEP * GST_MSECOND &&
+        now - probe->reportedAt >= LAG_REPORT_INTERVAL * GST_MSECOND)
+    {
+        probe->reportedLag = lag;
+        probe->reportedAt = now;
+
+        GstStructure* structure = gst_structure_new(
+            "lag",
+            "lag", G_TYPE_INT64, static_cast<gint64>(lag / GST_MSECOND),
+            nullptr);
+        gst_element_post_message(sink, gst_message_new_application(GST_OBJECT(sink), structure));
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
 void Peer::prepare(const WebRTCConfigPtr& webRTCConfig) noexcept
 {
     GstElementPtr pipelinePtr(gst_pipeline_new("Client Pipeline"));
@@ -87,20 +476,38 @@ void Peer::prepare(const WebRTCConfigPtr& webRTCConfig) noexcept
             GstCaps* vp8Caps = vp8CapsPtr.get();
             GstCaps* opusCaps = opusCapsPtr.get();
 
-            const gchar* decodeBinDescription = nullptr;
+            const bool lowLatency = self->_lowLatency;
+            const gchar* queue = lowLatency ? LowLatencyQueue : "queue";
+            const gchar* sink = lowLatency ? LowLatencySink : "qml6glsink name=qmlsink";
+
+            gchar* decodeBinDescription = nullptr;
             bool video = true;
             if(gst_caps_is_always_compatible(padCaps, h264Caps)) {
-                decodeBinDescription = "rtph264depay name=depay ! avdec_h264 ! videoconvert ! "
-                    "queue ! glupload ! qml6glsink name=qmlsink";
+                decodeBinDescription = g_strdup_printf(
+                    "rtph264depay name=depay ! %s ! videoconvert ! "
+                    "%s ! glupload ! %s",
+                    lowLatency ? LowLatencyH264Decoder : "avdec_h264",
+                    queue,
+                    sink);
             } else if(gst_caps_is_always_compatible(padCaps, h265Caps)) {
-                decodeBinDescription = "rtph265depay name=depay ! avdec_h265 ! "
+                decodeBinDescription = g_strdup_printf(
+                    "rtph265depay name=depay ! %s ! "
                     "capssetter caps=\"video/x-raw,colorimetry=bt709\" ! "
                     "videoconvert ! "
-                    "queue ! glupload ! qml6glsink name=qmlsink";
+                    "%s ! glupload ! %s",
+                    lowLatency ? LowLatencyH265Decoder : "avdec_h265",
+                    queue,
+                    sink);
             } else if(gst_caps_is_always_compatible(padCaps, vp8Caps)) {
-                decodeBinDescription = "rtpvp8depay ! vp8dec ! videoconvert ! queue ! glupload ! qml6glsink name=qmlsink";
+                decodeBinDescription = g_strdup_printf(
+                    "rtpvp8depay name=depay ! %s ! videoconvert ! %s ! glupload ! %s",
+                    lowLatency ? LowLatencyVp8Decoder : "vp8dec",
+                    queue,
+                    sink);
             } else if(gst_caps_is_always_compatible(padCaps, opusCaps)) {
-                decodeBinDescription = "rtpopusdepay ! opusdec ! audioconvert ! queue ! autoaudiosink";
+                decodeBinDescription = g_strdup_printf(
+                    "rtpopusdepay ! opusdec ! audioconvert ! %s ! autoaudiosink",
+                    queue);
                 video = false;
             }
 
@@ -109,35 +516,40 @@ void Peer::prepare(const WebRTCConfigPtr& webRTCConfig) noexcept
                     decodeBinDescription,
                     TRUE,
                     nullptr);
+                g_free(decodeBinDescription);
 
                 if(video) {
                     GstElementPtr sinkPtr(gst_bin_get_by_name(GST_BIN(decodeBin), "qmlsink"));
                     g_object_set(sinkPtr.get(), "widget", self->_view, nullptr);
+
+                    GstPadPtr sinkPadPtr(gst_element_get_static_pad(sinkPtr.get(), "sink"));
+                    gst_pad_add_probe(
+                        sinkPadPtr.get(),
+                        GST_PAD_PROBE_TYPE_BUFFER,
+                        &Peer::onSinkBuffer,
+                        new LagProbe { self },
+                        [] (gpointer userData) {
+                            delete static_cast<LagProbe*>(userData);
+                        });
                 }
                 gst_bin_add(GST_BIN(pipeline), decodeBin);
                 gst_element_sync_state_with_parent(decodeBin);
                 GstPad* sinkPad = (GstPad*)decodeBin->sinkpads->data;
                 if(video) {
                     GstElementPtr depayPtr(gst_bin_get_by_name(GST_BIN(decodeBin), "depay"));
-                    if(depayPtr) {
-                        GstPadPtr depaySrcPadPtr(gst_element_get_static_pad(depayPtr.get(), "src"));
-                        gst_pad_add_probe(
-                            depaySrcPadPtr.get(),
-                            GST_PAD_PROBE_TYPE_BUFFER,
-                            [] (GstPad* pad, GstPadProbeInfo* info, gpointer userData) -> GstPadProbeReturn {
-                                GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
-
-                                if(GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT))
-                                    return GST_PAD_PROBE_DROP;
-                                else {
-                                    Peer::postCanPlay(GST_PAD_PARENT(pad));
-                                    return GST_PAD_PROBE_REMOVE;
-                                }
-                            },
-                            nullptr,
-                            nullptr
-                        );
-                    }
+                    GstPadPtr depaySrcPadPtr(
+                        depayPtr ? gst_element_get_static_pad(depayPtr.get(), "src") : nullptr);
+                    if(depaySrcPadPtr)
+                        Peer::waitKeyFrame(depaySrcPadPtr.get(), true, false);
+
+                    gst_pad_add_probe(
+                        sinkPad,
+                        static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+                        &Peer::onDecodeBinRtp,
+                        new SuspendProbe { self, depaySrcPadPtr.get() },
+                        [] (gpointer userData) {
+                            delete static_cast<SuspendProbe*>(userData);
+                        });
                 }
                 gst_pad_link(pad, sinkPad);
             }
@@ -148,9 +560,13 @@ void Peer::prepare(const WebRTCConfigPtr& webRTCConfig) noexcept
         G_CALLBACK(onPadAddedCallback),
         this);
 
+    _rtcbin = rtcbin;
+
     setPipeline(std::move(pipelinePtr));
     setWebRtcBin(*webRTCConfig, std::move(rtcbinPtr));
 
+    applyLatency();
+
     pause();
 }
 
@@ -160,6 +576,26 @@ gboolean Peer::onBusMessage(GstMessage* message) noexcept
         if(gst_message_has_name(message, "can-play")) {
             emit canPlay();
             return TRUE;
+        } else if(gst_message_has_name(message, "lag")) {
+            const GstStructure* structure = gst_message_get_structure(message);
+            gint64 lag = 0;
+            gst_structure_get_int64(structure, "lag", &lag);
+            emit lagChanged(static_cast<int>(lag));
+            return TRUE;
+        } else if(gst_message_has_name(message, "caught-up")) {
+            const GstStructure* structure = gst_message_get_structure(message);
+            gint64 skipped = 0;
+            guint dropped = 0;
+            gst_structure_get_int64(structure, "skipped", &skipped);
+            gst_structure_get_uint(structure, "dropped", &dropped);
+            emit caughtUp(static_cast<int>(skipped), static_cast<int>(dropped));
+            return TRUE;
+        } else if(gst_message_has_name(message, "latency")) {
+            const GstStructure* structure = gst_message_get_structure(message);
+            guint latency = 0;
+            if(gst_structure_get_uint(structure, "latency", &latency))
+                emit latencyChanged(static_cast<int>(latency));
+            return TRUE;
         }
     }
 
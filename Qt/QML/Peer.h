@@ -1,8 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include <QObject>
 #include <QQuickItem>
 
+#include <CxxPtr/GlibPtr.h>
+
 #include "RtStreaming/GstRtStreaming/GstWebRTCPeer.h"
 
 
@@ -13,12 +18,30 @@ class Peer : public QObject, public GstWebRTCPeer
     Q_OBJECT
 
 public:
-    Peer(QQuickItem* view, const WebRTCConfigPtr& webRTCConfig) noexcept :
-        GstWebRTCPeer(Role::Viewer), _view(view), _webRTCConfig(webRTCConfig) {}
-    ~Peer() noexcept override {}
+    // latency < 0 - webrtcbin default jitter buffer latency
+    Peer(
+        QQuickItem* view,
+        const WebRTCConfigPtr& webRTCConfig,
+        bool lowLatency = false,
+        int latency = -1,
+        bool adaptiveLatency = false) noexcept;
+    ~Peer() noexcept override;
 
     void prepare() noexcept;
 
+    // can be called from any thread.
+    // Decode chain tuning is applied only to tracks not linked yet,
+    // catch up to live - immediately.
+    void setLowLatency(bool lowLatency) noexcept { _lowLatency = lowLatency; }
+
+    // can be called from any thread.
+    // Video RTP is dropped while suspended, decoding resumes from key frame
+    void setDecodeSuspended(bool suspended) noexcept { _decodeSuspended = suspended; }
+
+    // should be called on actor thread.
+    // Adaptive mode starts from configured latency and tunes it from jitter and loss stats
+    void setLatency(int latency, bool adaptive) noexcept;
+
     using GstWebRTCPeer::play;
 
 signals:
@@ -26,6 +49,9 @@ signals:
     void iceCandidate(unsigned mlineIndex, const std::string& candidate);
     void eos();
     void canPlay();
+    void lagChanged(int lag); // ms behind live
+    void caughtUp(int skipped, int droppedFrames); // skipped ms
+    void latencyChanged(int latency); // applied jitter buffer latency, ms
 
 protected:
     void prepare(const WebRTCConfigPtr&) noexcept override;
@@ -33,11 +59,31 @@ protected:
     gboolean onBusMessage(GstMessage*) noexcept override;
 
 private:
+    struct SuspendProbe;
+    struct KeyFrameWait;
+    struct LagProbe;
+    struct LatencyControl;
+
+    static void waitKeyFrame(GstPad* depaySrcPad, bool postCanPlay, bool requestKeyFrame);
+    static GstPadProbeReturn onDecodeBinRtp(GstPad*, GstPadProbeInfo*, gpointer);
+    static void requestKeyUnit(GstPad*);
     static void postCanPlay(GstElement*);
+    static GstPadProbeReturn onSinkBuffer(GstPad*, GstPadProbeInfo*, gpointer);
+
+    void applyLatency() noexcept;
+    void requestStats() noexcept;
 
 private:
     QQuickItem *const _view;
     const WebRTCConfigPtr _webRTCConfig;
+    std::atomic<bool> _lowLatency;
+    std::atomic<bool> _decodeSuspended = false;
+
+    int _latency;
+    bool _adaptiveLatency;
+    GstElement* _rtcbin = nullptr; // owned by pipeline
+    std::shared_ptr<LatencyControl> _latencyControl;
+    GSourcePtr _statsSourcePtr;
 };
 
 }
@@ -1,13 +1,15 @@
 #include "Player.h"
 
+#include <QQuickWindow>
+
 #include "RtspParser/RtspParser.h"
 
 #include "Log.h"
 #include "Connection.h"
 
 enum {
-    RECONNECT_INTERVAL_MIN = 1, // seconds
-    RECONNECT_INTERVAL_MAX = 5, // seconds
+    RECONNECT_BACKOFF_MIN = 500, // ms
+    RECONNECT_BACKOFF_MAX = 10000, // ms
 };
 
 using namespace webrtsp::qml;
@@ -19,7 +21,12 @@ Player::Player(
     ConnectionClient(connection),
     _uri(uri),
     _encodedUri(uri == "*" ? uri.toStdString() : QUrl::toPercentEncoding(uri).toStdString()),
-    _view(view)
+    _view(view),
+    _latency(connection->latency()),
+    _adaptiveLatency(connection->adaptiveLatency()),
+    _reconnectBackoff(
+        std::chrono::milliseconds(RECONNECT_BACKOFF_MIN),
+        std::chrono::milliseconds(RECONNECT_BACKOFF_MAX))
 {
     static thread_local std::weak_ptr<QActor> sharedActor;
 
@@ -33,6 +40,14 @@ Player::Player(
     _reconnectTimer.setSingleShot(true);
     QObject::connect(&_reconnectTimer, &QTimer::timeout, this, &Player::play);
 
+    if(view) {
+        QObject::connect(view, &QQuickItem::visibleChanged, this, &Player::updateDecodeSuspension);
+        QObject::connect(view, &QQuickItem::widthChanged, this, &Player::updateDecodeSuspension);
+        QObject::connect(view, &QQuickItem::heightChanged, this, &Player::updateDecodeSuspension);
+        QObject::connect(view, &QQuickItem::windowChanged, this, &Player::viewWindowChanged);
+        viewWindowChanged(view->window());
+    }
+
     if(connection->isOpen()) {
         onConnected();
     }
@@ -43,6 +58,95 @@ Player::~Player() noexcept
     reset();
 }
 
+void Player::setLowLatency(bool lowLatency) noexcept
+{
+    if(_lowLatency == lowLatency)
+        return;
+
+    _lowLatency = lowLatency;
+    if(_peer)
+        _peer->setLowLatency(lowLatency);
+
+    emit lowLatencyChanged();
+}
+
+void Player::setLatency(int latency) noexcept
+{
+    if(_latency == latency)
+        return;
+
+    _latency = latency;
+    updatePeerLatency();
+
+    emit latencyChanged();
+}
+
+void Player::setAdaptiveLatency(bool adaptiveLatency) noexcept
+{
+    if(_adaptiveLatency == adaptiveLatency)
+        return;
+
+    _adaptiveLatency = adaptiveLatency;
+    updatePeerLatency();
+
+    emit adaptiveLatencyChanged();
+}
+
+void Player::updatePeerLatency() noexcept
+{
+    if(!_peer)
+        return;
+
+    _actor->postAction([peer = _peer, latency = _latency, adaptive = _adaptiveLatency] () {
+        peer->setLatency(latency, adaptive);
+    });
+}
+
+void Player::setSuspendHidden(bool suspendHidden) noexcept
+{
+    if(_suspendHidden == suspendHidden)
+        return;
+
+    _suspendHidden = suspendHidden;
+    updateDecodeSuspension();
+
+    emit suspendHiddenChanged();
+}
+
+void Player::viewWindowChanged(QQuickWindow* window) noexcept
+{
+    QObject::disconnect(_windowVisibilityConnection);
+    if(window) {
+        _windowVisibilityConnection =
+            QObject::connect(window, &QWindow::visibilityChanged, this, &Player::updateDecodeSuspension);
+    }
+
+    updateDecodeSuspension();
+}
+
+void Player::updateDecodeSuspension() noexcept
+{
+    QQuickWindow* window = _view ? _view->window() : nullptr;
+    const bool hidden =
+        !_view || !_view->isVisible() ||
+        _view->width() <= 0 || _view->height() <= 0 ||
+        !window ||
+        window->visibility() == QWindow::Hidden ||
+        window->visibility() == QWindow::Minimized;
+
+    const bool suspended = _suspendHidden && hidden;
+    if(_decodeSuspended == suspended)
+        return;
+
+    _decodeSuspended = suspended;
+    if(_peer)
+        _peer->setDecodeSuspended(suspended);
+
+    qDebug(QmlClient) << "Decoding of" << _uri << (suspended ? "suspended" : "resumed");
+
+    emit decodeSuspendedChanged();
+}
+
 void Player::reset()
 {
     if(!_peer)
@@ -50,21 +154,30 @@ void Player::reset()
 
     _reconnectTimer.stop();
 
-    // use sendAction to be sure peer doestroyed before possibler Player destroy
-    _actor->sendAction([peer = std::move(_peer)] () mutable {
+    // pipeline can take a while to reach NULL state, so don't wait for it on UI thread.
+    // Actor is kept alive by continuation, so if it's the last reference
+    // actor thread will be stopped only after peer destroy.
+    _actor->sendActionAsync([peer = std::move(_peer)] () mutable {
         peer.reset();
-    });
+    }).then(QCoreApplication::instance(), [actor = _actor] () {});
 
     _describeCSeq = rtsp::InvalidCSeq;
     _mediaSession.clear();
+
+    if(_lag != 0) {
+        _lag = 0;
+        emit lagChanged();
+    }
+    if(_currentLatency != -1) {
+        _currentLatency = -1;
+        emit currentLatencyChanged();
+    }
 }
 
 void Player::scheduleReconnect() noexcept
 {
-    const int delay = QRandomGenerator::global()->bounded(
-            RECONNECT_INTERVAL_MIN * 1000,
-            RECONNECT_INTERVAL_MAX * 1000);
-    qDebug(QmlClient) << "Scheduled reconnect to streamer in" << delay << "ms";
+    const std::chrono::milliseconds delay = _reconnectBackoff.next();
+    qDebug(QmlClient) << "Scheduled reconnect to streamer in" << delay.count() << "ms";
     _reconnectTimer.start(delay);
 }
 
@@ -75,10 +188,29 @@ void Player::play()
 
     _reconnectTimer.stop();
 
-    _peer = std::make_shared<Peer>(_view, connection()->webRTCConfig());
+    _peer = std::make_shared<Peer>(
+        _view,
+        connection()->webRTCConfig(),
+        _lowLatency,
+        _latency,
+        _adaptiveLatency);
+    _peer->setDecodeSuspended(_decodeSuspended);
     _peer->moveToThread(_actor->actorThread());
 
+    QObject::connect(_peer.get(), &Peer::prepared, this, &Player::peerPrepared);
+    QObject::connect(_peer.get(), &Peer::iceCandidate, this, &Player::iceCandidate);
+    QObject::connect(_peer.get(), &Peer::eos, this, &Player::eos);
+    QObject::connect(_peer.get(), &Peer::canPlay, this, &Player::peerCanPlay);
+    QObject::connect(_peer.get(), &Peer::lagChanged, this, &Player::peerLagChanged);
+    QObject::connect(_peer.get(), &Peer::caughtUp, this, &Player::caughtUp);
+    QObject::connect(_peer.get(), &Peer::latencyChanged, this, &Player::peerLatencyChanged);
+
     _describeCSeq = connection()->requestDescribe(this, _encodedUri);
+
+    // pipeline is built while DESCRIBE is in flight, so only remote SDP is left to apply on response
+    _actor->postAction([peer = _peer] () {
+        peer->prepare();
+    });
 }
 
 void Player::onConnected() noexcept
@@ -112,6 +244,35 @@ void Player::iceCandidate(
         candidate);
 }
 
+void Player::peerLagChanged(int lag)
+{
+    // could be queued before peer was reset
+    if(sender() != _peer.get() || _lag == lag)
+        return;
+
+    _lag = lag;
+    emit lagChanged();
+}
+
+void Player::peerLatencyChanged(int latency)
+{
+    if(sender() != _peer.get() || _currentLatency == latency)
+        return;
+
+    _currentLatency = latency;
+    emit currentLatencyChanged();
+}
+
+void Player::peerCanPlay()
+{
+    if(sender() != _peer.get())
+        return;
+
+    _reconnectBackoff.reset();
+
+    emit canPlay();
+}
+
 void Player::eos()
 {
     Q_ASSERT(connection()->isOpen());
@@ -149,13 +310,7 @@ bool Player::onDescribeResponse(
     if(sdp.empty())
         return false;
 
-    QObject::connect(_peer.get(), &Peer::prepared, this, &Player::peerPrepared);
-    QObject::connect(_peer.get(), &Peer::iceCandidate, this, &Player::iceCandidate);
-    QObject::connect(_peer.get(), &Peer::eos, this, &Player::eos);
-    QObject::connect(_peer.get(), &Peer::canPlay, this, &Player::canPlay);
-
-    _actor->postAction([peer = _peer, sdp] () mutable {
-        peer->prepare();
+    _actor->postAction([peer = _peer, sdp] () {
         peer->setRemoteSdp(sdp);
     });
 
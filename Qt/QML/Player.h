@@ -5,6 +5,7 @@
 
 #include "../QActor.h"
 
+#include "Backoff.h"
 #include "Peer.h"
 #include "ConnectionClient.h"
 
@@ -19,9 +20,36 @@ class Player: public ConnectionClient
     QML_UNCREATABLE("Type is only available as property value")
 
 public:
+    // decoders drop frames on QoS, queues are leaky and frames are skipped
+    // when playback falls behind live
+    Q_PROPERTY(bool lowLatency READ lowLatency WRITE setLowLatency NOTIFY lowLatencyChanged)
+    Q_PROPERTY(int lag READ lag NOTIFY lagChanged) // ms behind live
+    // jitter buffer latency in ms, -1 - webrtcbin default. Initialized from connection
+    Q_PROPERTY(int latency READ latency WRITE setLatency NOTIFY latencyChanged)
+    Q_PROPERTY(bool adaptiveLatency READ adaptiveLatency WRITE setAdaptiveLatency NOTIFY adaptiveLatencyChanged)
+    Q_PROPERTY(int currentLatency READ currentLatency NOTIFY currentLatencyChanged) // actually used
+    // suspend video decoding while view is invisible, zero-sized or in hidden/minimized window
+    Q_PROPERTY(bool suspendHidden READ suspendHidden WRITE setSuspendHidden NOTIFY suspendHiddenChanged)
+    Q_PROPERTY(bool decodeSuspended READ decodeSuspended NOTIFY decodeSuspendedChanged)
+
     Player(Connection*, const QString& uri, QQuickItem* view) noexcept;
     ~Player() noexcept;
 
+    bool lowLatency() const noexcept { return _lowLatency; }
+    void setLowLatency(bool) noexcept;
+
+    int lag() const noexcept { return _lag; }
+
+    int latency() const noexcept { return _latency; }
+    void setLatency(int) noexcept;
+    bool adaptiveLatency() const noexcept { return _adaptiveLatency; }
+    void setAdaptiveLatency(bool) noexcept;
+    int currentLatency() const noexcept { return _currentLatency; }
+
+    bool suspendHidden() const noexcept { return _suspendHidden; }
+    void setSuspendHidden(bool) noexcept;
+    bool decodeSuspended() const noexcept { return _decodeSuspended; }
+
 private:
     class WebRTSPPeer;
 
@@ -41,25 +69,48 @@ private:
     bool onTeardownRequest(std::unique_ptr<rtsp::Request>&) noexcept override;
 
     void scheduleReconnect() noexcept;
+    void updatePeerLatency() noexcept;
+    void viewWindowChanged(QQuickWindow*) noexcept;
+    void updateDecodeSuspension() noexcept;
 
 private slots:
     void play();
     void peerPrepared(const std::string& sdp);
     void iceCandidate(unsigned, const std::string& candidate);
     void eos();
+    void peerLagChanged(int lag);
+    void peerLatencyChanged(int latency);
+    void peerCanPlay();
 
 signals:
     void canPlay();
+    void lowLatencyChanged();
+    void lagChanged();
+    void caughtUp(int skipped, int droppedFrames); // skipped ms
+    void latencyChanged();
+    void adaptiveLatencyChanged();
+    void currentLatencyChanged();
+    void suspendHiddenChanged();
+    void decodeSuspendedChanged();
 
 private:
     const QString _uri;
     const std::string _encodedUri;
     QPointer<QQuickItem> _view;
+    bool _lowLatency = false;
+    int _lag = 0;
+    int _latency;
+    bool _adaptiveLatency;
+    int _currentLatency = -1;
+    bool _suspendHidden = true;
+    bool _decodeSuspended = false;
+    QMetaObject::Connection _windowVisibilityConnection;
 
     std::shared_ptr<QActor> _actor;
     std::shared_ptr<Peer> _peer;
 
     QTimer _reconnectTimer;
+    Backoff _reconnectBackoff;
 
     rtsp::CSeq _describeCSeq = rtsp::InvalidCSeq;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 #include <deque>
 #include <map>
 #include <optional>
@@ -10,6 +11,7 @@
 #include <spdlog/common.h>
 
 #include "RtStreaming/WebRTCConfig.h"
+#include "Auth/TokenSigner.h"
 
 
 namespace webrtsp::qt {
@@ -20,10 +22,26 @@ struct StreamerConfig
         ReStreamer,
     };
 
+    enum class Policy {
+        AlwaysOn,
+        OnDemand, // started on first viewer, stopped after linger timeout since last viewer
+        Prewarm,  // as AlwaysOn inside prewarm windows, as OnDemand outside of them
+    };
+
+    // minutes since local midnight, end < begin means window wraps over midnight
+    struct Window {
+        std::chrono::minutes begin;
+        std::chrono::minutes end;
+    };
+
     Type type;
     std::string uri;
     std::string description;
     std::string forceH264ProfileLevelId;
+
+    Policy policy = Policy::AlwaysOn;
+    std::chrono::seconds linger = std::chrono::seconds(30);
+    std::vector<Window> prewarmWindows;
 };
 
 
@@ -32,6 +50,11 @@ struct Config
     std::shared_ptr<WebRTCConfig> webRTCConfig = std::make_shared<WebRTCConfig>();
     std::map<std::string, StreamerConfig> streamers; // escaped streamer name -> StreamerConfig
     std::string authToken;
+    std::shared_ptr<const auth::TokenSigner> authTokenSigner;
+    // every actor thread gets own set of streamers,
+    // so every restreamer connects to its source once per actor.
+    // 0 - QThread::idealThreadCount()
+    unsigned actorsCount = 1;
 };
 
 }
@@ -1,5 +1,7 @@
 #include "Server.h"
 
+#include <mutex>
+
 #include <QWebSocket>
 #include <QTimer>
 #include <QPointer>
@@ -7,8 +9,7 @@
 #include "Signalling/Config.h"
 #include "RtspParser/RtspParser.h"
 #include "RtspParser/RtspSerialize.h"
-
-#include "RtStreaming/GstRtStreaming/GstReStreamer2.h"
+#include "Metrics/Metrics.h"
 
 
 using namespace webrtsp::qt;
@@ -19,6 +20,28 @@ enum {
     FIRST_REQUEST_WITHOUT_AUTH_DELAY = 1 // seconds
 };
 
+metrics::Counter& ConnectionsCounter()
+{
+    static metrics::Counter& counter =
+        metrics::Registry::Default().counter(
+            "webrtsp_connections_total",
+            "Accepted signalling connections",
+            { { "transport", "qt" } });
+
+    return counter;
+}
+
+metrics::Gauge& ActiveConnectionsGauge()
+{
+    static metrics::Gauge& gauge =
+        metrics::Registry::Default().gauge(
+            "webrtsp_active_connections",
+            "Open signalling connections",
+            { { "transport", "qt" } });
+
+    return gauge;
+}
+
 std::string GenerateList(const Config& config) noexcept
 {
     std::string list;
@@ -32,100 +55,142 @@ std::string GenerateList(const Config& config) noexcept
     return list;
 }
 
-Session::Streamers GenerateStreamers(const Config& config) noexcept
+}
+
+struct Server::ConnectionContext
 {
-    Session::Streamers streamers;
+    Server *const owner;
+    QWebSocket *const connection;
+    QActor *const actor;
+    const unsigned actorIndex;
+    std::shared_ptr<Session> session;
+
+    // main thread only
+    bool firstMessageReceived = false;
+    bool waitingFirstMessage = false;
+
+    // client's last message was binary, so replies should be binary too
+    std::atomic<bool> binary = false;
+
+    std::mutex outgoingGuard;
+    std::vector<std::string> outgoing;
+    bool flushScheduled = false;
+    bool closeRequested = false;
+};
 
-    for(const auto& pair: config.streamers) {
-        switch(pair.second.type) {
-        case StreamerConfig::Type::ReStreamer:
-            streamers.emplace(
-                pair.first,
-                std::make_unique<GstReStreamer2>(
-                    pair.second.uri,
-                    pair.second.forceH264ProfileLevelId));
-            break;
-        default:
-            break;
-        }
-    }
+void Server::HandleMessage(
+    ConnectionContext* context,
+    const char* message,
+    size_t size) noexcept
+{
+    Session* session = context->session.get();
 
-    return streamers;
-}
+    qDebug() << "WebRTSP Server <-" << QByteArrayView(message, size);
 
-std::unique_ptr<WebRTCPeer> CreatePeer(
-    Session::SharedData* sharedData,
-    const std::string& uri) noexcept
-{
-    auto it = sharedData->streamers.find(uri);
-    if(it == sharedData->streamers.end())
-        return nullptr;
+    if(rtsp::IsRequest(message, size)) {
+        std::unique_ptr<rtsp::Request> requestPtr = std::make_unique<rtsp::Request>();
+        if(!rtsp::ParseRequest(message, size, requestPtr.get())) {
+            qWarning()
+                << "Failed to parse request:" << Qt::endl
+                << QByteArrayView(message, size) << Qt::endl
+                << "Forcing disconnect...";
 
-    return it->second->createPeer();
-}
+            RequestClose(context);
+            return;
+        }
 
-}
+        if(!session->handleRequest(std::move(requestPtr))) {
+            qWarning() << "Failed to handle request. Forcing disconnect...";
+            RequestClose(context);
+        }
+    } else {
+        std::unique_ptr<rtsp::Response> responsePtr = std::make_unique<rtsp::Response>();
+        if(!rtsp::ParseResponse(message, size, responsePtr.get())) {
+            qWarning()
+                << "Failed to parse response:" << Qt::endl
+                << QByteArrayView(message, size) << Qt::endl
+                << "Forcing disconnect...";
 
-void Server::CloseConnection(
-    Server* owner,
-    QWebSocket* connection) noexcept
-{
-    QMetaObject::invokeMethod(
-        owner,
-        &Server::closeConnection,
-        connection);
-}
+            RequestClose(context);
+            return;
+        }
 
-void Server::SendMessage(
-    Server* owner,
-    QWebSocket* connection,
-    const std::string& message) noexcept
-{
-    QMetaObject::invokeMethod(
-        owner,
-        &Server::sendMessage,
-        connection,
-        message);
+        if(!session->handleResponse(std::move(responsePtr))) {
+            qWarning() << "Failed to handle response. Forcing disconnect...";
+            RequestClose(context);
+        }
+    }
 }
 
 void Server::SendRequest(
-    Server* owner,
-    QWebSocket* connection,
+    ConnectionContext* context,
     const rtsp::Request* request) noexcept
 {
     if(!request) {
-        CloseConnection(owner, connection);
+        RequestClose(context);
         return;
     }
 
-    const std::string serializedRequest = rtsp::Serialize(*request);
+    std::string serializedRequest = rtsp::Serialize(*request);
     if(serializedRequest.empty()) {
-        CloseConnection(owner, connection);
+        RequestClose(context);
         return;
     }
 
-    SendMessage(owner, connection, serializedRequest);
+    QueueMessage(context, std::move(serializedRequest));
 }
 
 void Server::SendResponse(
-    Server* owner,
-    QWebSocket* connection,
+    ConnectionContext* context,
     const rtsp::Response* response) noexcept
 {
     if(!response) {
-        CloseConnection(owner, connection);
+        RequestClose(context);
         return;
     }
 
-    const std::string serializedResponse = rtsp::Serialize(*response);
+    std::string serializedResponse = rtsp::Serialize(*response);
     if(serializedResponse.empty()) {
-        CloseConnection(owner, connection);
+        RequestClose(context);
         return;
     }
 
-    SendMessage(owner, connection, serializedResponse);
+    QueueMessage(context, std::move(serializedResponse));
 }
 
+void Server::ScheduleFlush(ConnectionContext* context) noexcept
+{
+    if(context->flushScheduled)
+        return;
+
+    // single main thread hop per batch of messages
+    context->flushScheduled = true;
+    QMetaObject::invokeMethod(
+        context->owner,
+        [owner = context->owner, connection = context->connection, context] () {
+            owner->flushOutgoing(connection, context);
+        });
+}
+
+void Server::QueueMessage(
+    ConnectionContext* context,
+    std::string&& message) noexcept
+{
+    std::lock_guard lock(context->outgoingGuard);
+
+    context->outgoing.emplace_back(std::move(message));
+
+    ScheduleFlush(context);
+}
+
+void Server::RequestClose(ConnectionContext* context) noexcept
+{
+    std::lock_guard lock(context->outgoingGuard);
+
+    context->closeRequested = true;
+
+    ScheduleFlush(context);
+}
 
 Server::Server(
     const Config* config,
@@ -138,8 +203,20 @@ Server::Server(
             QWebSocketServer::SecureMode,
         nullptr),
     _config(config),
-    _sharedData { GenerateList(*config), GenerateStreamers(*config) }
+    _actors(config->actorsCount)
 {
+    const std::string list = GenerateList(*config);
+    for(unsigned i = 0; i < _actors.size(); ++i) {
+        _sharedData.emplace_back(
+            new Session::SharedData { list, StreamerManager(config->streamers) });
+
+        // queued before any session, so streamers are ready on first createPeer
+        Session::SharedData* sharedData = _sharedData.back().get();
+        _actors.actor(i)->postAction([sharedData] () {
+            sharedData->streamers.start();
+        });
+    }
+
     if(!sslConfig.localCertificate().isNull())
         setSslConfiguration(sslConfig);
 
@@ -172,74 +249,82 @@ void Server::connectionOrphaned(QWebSocket* connection) noexcept
 
 void Server::clientConnected(QWebSocket* connection) noexcept
 {
+    ConnectionsCounter().inc();
+    ActiveConnectionsGauge().inc();
+
     QObject::connect(
         connection,
         &QWebSocket::textMessageReceived,
         this,
-        [this] (const QString& message) {
-            if(QWebSocket* connection = static_cast<QWebSocket*>(sender())) {
-                textMessageReceived(connection, message);
-            }
+        [this, connection] (const QString& message) {
+            textMessageReceived(connection, message);
         });
     QObject::connect(
         connection,
         &QWebSocket::binaryMessageReceived,
         this,
-        [this] (const QByteArray& message) {
-            if(QWebSocket* connection = static_cast<QWebSocket*>(sender())) {
-                binaryMessageReceived(connection, message);
-            }
+        [this, connection] (const QByteArray& message) {
+            binaryMessageReceived(connection, message);
         });
     QObject::connect(
         connection,
         &QWebSocket::disconnected,
         this,
-        [this] () {
-            if(QWebSocket* connection = static_cast<QWebSocket*>(sender())) {
-                clientDisconnected(connection);
-            }
+        [this, connection] () {
+            clientDisconnected(connection);
         });
 
-    std::shared_ptr<Session> session = std::make_shared<Session>(
+    const unsigned actorIndex = _actors.acquire();
+    Session::SharedData* sharedData = _sharedData[actorIndex].get();
+
+    std::shared_ptr<ConnectionContext> context(
+        new ConnectionContext { this, connection, _actors.actor(actorIndex), actorIndex, {} });
+
+    context->session = std::make_shared<Session>(
         _config,
-        &_sharedData,
-        [sharedData = &_sharedData] (const std::string& uri) {
-            return CreatePeer(sharedData, uri);
+        sharedData,
+        [sharedData] (const std::string& uri) {
+            return sharedData->streamers.createPeer(uri);
         },
-        [owner = this, connection] (const rtsp::Request* request) {
-            Server::SendRequest(owner, connection, request);
+        [context = context.get()] (const rtsp::Request* request) {
+            Server::SendRequest(context, request);
         },
-        [owner = this, connection] (const rtsp::Response* response) {
-            Server::SendResponse(owner, connection, response);
+        [context = context.get()] (const rtsp::Response* response) {
+            Server::SendResponse(context, response);
         });
-    connection->setProperty("session", QVariant::fromValue(session.get()));
-    _sessions.emplace(connection, session);
-    session->moveToThread(_actor.actorThread());
+    _connections.emplace(connection, context);
+
+    Session* session = context->session.get();
+    session->moveToThread(context->actor->actorThread());
     QPointer connectionPointer(connection);
     QObject::connect(
-        session.get(), &Session::authorized,
+        session, &Session::authorized,
         this, [this, connectionPointer] () {
             Q_ASSERT(connectionPointer);
             emit clientAuthorized(connectionPointer);
         });
 
-    _actor.postAction([session] () {
+    context->actor->postAction([session] () {
         session->onConnected();
     });
 }
 
 void Server::clientDisconnected(QWebSocket* connection) noexcept
 {
-    connection->setProperty("session", QVariant());
     connection->disconnect(this);
 
-    if(auto it = _sessions.find(connection); it != _sessions.end()) {
-        std::shared_ptr<Session> session = it->second;
-        _sessions.erase(it);
+    if(auto it = _connections.find(connection); it != _connections.end()) {
+        std::shared_ptr<ConnectionContext> context = std::move(it->second);
+        _connections.erase(it);
+
+        ActiveConnectionsGauge().dec();
 
-        _actor.postAction([owner = this, connection, session = std::move(session)] () mutable {
-            Q_ASSERT(session.use_count() == 1);
-            session.reset();
+        _actors.release(context->actorIndex);
+        context->actor->postAction([owner = this, connection, context = std::move(context)] () mutable {
+            Q_ASSERT(context->session.use_count() == 1);
+            context->session.reset();
+            // session callbacks reference context, so it's destroyed only after session
+            context.reset();
             // It's required to be sure main thread never receives notification
             // referencing a specific connection after connection is destroyed.
             // And it's very bad idea to keep pointer do destroyed session somewhere
@@ -259,12 +344,42 @@ void Server::clientDisconnected(QWebSocket* connection) noexcept
 
 void Server::closeConnection(QWebSocket* connection) noexcept
 {
-    if(_sessions.find(connection) == _sessions.end())
+    if(_connections.find(connection) == _connections.end())
         return;
 
     connection->close();
 }
 
+void Server::flushOutgoing(QWebSocket* connection, ConnectionContext* context) noexcept
+{
+    // context pointer is compared only, since it can be already destroyed if connection is closed
+    auto it = _connections.find(connection);
+    if(it == _connections.end() || it->second.get() != context)
+        return;
+
+    std::vector<std::string> outgoing;
+    bool closeRequested;
+    {
+        std::lock_guard lock(context->outgoingGuard);
+        outgoing.swap(context->outgoing);
+        closeRequested = context->closeRequested;
+        context->flushScheduled = false;
+    }
+
+    const bool binary = context->binary.load(std::memory_order_relaxed);
+    for(const std::string& message: outgoing) {
+        qDebug() << "WebRTSP Server ->" << message;
+
+        if(binary)
+            sendBinaryMessage(connection, QByteArray(message.data(), message.size()));
+        else
+            sendTextMessage(connection, QString::fromUtf8(message.data(), message.size()));
+    }
+
+    if(closeRequested)
+        closeConnection(connection);
+}
+
 void Server::sendTextMessage(QWebSocket* connection, const QString& message) noexcept
 {
     connection->sendTextMessage(message);
@@ -275,103 +390,80 @@ void Server::sendBinaryMessage(QWebSocket* connection, const QByteArray& message
     connection->sendBinaryMessage(message);
 }
 
-void Server::sendMessage(QWebSocket* connection, const std::string& message) noexcept
+void Server::dispatchMessage(ConnectionContext* context, QActor::Action&& action) noexcept
 {
-    qDebug() << "WebRTSP Server ->" << message;
+    if(FIRST_REQUEST_WITHOUT_AUTH_DELAY &&
+        (!_config->authToken.empty() || _config->authTokenSigner))
+    {
+        if(!context->firstMessageReceived) {
+            context->firstMessageReceived = true;
+            context->waitingFirstMessage = true;
+
+            // delay very first request to complicate token brute force
+            QTimer::singleShot(
+                FIRST_REQUEST_WITHOUT_AUTH_DELAY * 1000,
+                context->connection,
+                [this, connection = context->connection, context, action = std::move(action)] () mutable {
+                    auto it = _connections.find(connection);
+                    if(it == _connections.end() || it->second.get() != context)
+                        return;
+
+                    context->waitingFirstMessage = false;
+                    context->actor->postAction(std::move(action));
+                }
+            );
+            return;
+        } else if(context->waitingFirstMessage) {
+            // got second request without waiting very first answer
+            closeConnection(context->connection);
+            return;
+        }
+    }
 
-    sendTextMessage(connection, QString::fromStdString(message));
+    context->actor->postAction(std::move(action));
 }
 
 void Server::textMessageReceived(QWebSocket* connection, const QString& message) noexcept
 {
-    qDebug() << "WebRTSP Server <-" << message;
-
-    const std::string tmpMessage = message.toStdString();
-    if(rtsp::IsRequest(tmpMessage.data(), tmpMessage.size())) {
-        std::unique_ptr<rtsp::Request> requestPtr = std::make_unique<rtsp::Request>();
-        if(!rtsp::ParseRequest(tmpMessage.data(), tmpMessage.size(), requestPtr.get())) {
-            qWarning()
-                << "Failed to parse request:" << Qt::endl
-                << message << Qt::endl
-                << "Forcing disconnect...";
-
-            closeConnection(connection);
-            return;
-        }
-
-        handleRequest(connection, std::move(requestPtr));
-    } else {
-        std::unique_ptr<rtsp::Response> responsePtr = std::make_unique<rtsp::Response>();
-        if(!rtsp::ParseResponse(tmpMessage.data(), tmpMessage.size(), responsePtr.get())) {
-            qWarning()
-                << "Failed to parse response:" << Qt::endl
-                << message << Qt::endl
-                << "Forcing disconnect...";
+    auto it = _connections.find(connection);
+    if(it == _connections.end())
+        return;
 
-            closeConnection(connection);
-            return;
-        }
+    ConnectionContext* context = it->second.get();
+    context->binary.store(false, std::memory_order_relaxed);
 
-        handleResponse(connection, std::move(responsePtr));
-    }
+    postMessage(context, message);
 }
 
-void Server::handleRequest(
-    QWebSocket* connection,
-    std::unique_ptr<rtsp::Request>&& requestPtr) noexcept
+void Server::binaryMessageReceived(QWebSocket* connection, const QByteArray& message) noexcept
 {
-    Session* session = connection->property("session").value<Session*>();
-    if(!session)
+    auto it = _connections.find(connection);
+    if(it == _connections.end())
         return;
 
-    if(FIRST_REQUEST_WITHOUT_AUTH_DELAY && !_config->authToken.empty()) {
-        QVariant waiting = connection->property("waiting");
-        if(waiting.isNull()) {
-            connection->setProperty("waiting", true);
+    ConnectionContext* context = it->second.get();
+    context->binary.store(true, std::memory_order_relaxed);
 
-            // delay very first request to complicate token brute force
-            QTimer::singleShot(
-                FIRST_REQUEST_WITHOUT_AUTH_DELAY * 1000,
-                connection,
-                [this, connection, requestPtr = std::move(requestPtr)] () mutable {
-                    connection->setProperty("waiting", false);
-                    handleRequest(connection, std::move(requestPtr));
-                }
-            );
-            return;
-        } else if(waiting.toBool()) {
-            // got second request without waiting very first answer
-            closeConnection(connection);
-            return;
-        }
-    }
+    postMessage(context, message);
+}
 
-    // it's better to use std::move_only_function here, but it's from too fresh c++23
-    _actor.postAction([owner = this, connection, session, request = requestPtr.release()] () {
-        if(!session->handleRequest(std::unique_ptr<rtsp::Request>(request))) {
-            qWarning() << "Failed to handle request. Forcing disconnect...";
-            QMetaObject::invokeMethod(
-                owner,
-                &Server::closeConnection,
-                connection);
-        }
-    });
+void Server::postMessage(ConnectionContext* context, const QString& message) noexcept
+{
+    // QString is implicitly shared, so it's cheap to pass it to actor
+    // and do UTF-8 conversion there
+    auto action = [context, message] () {
+        const QByteArray utf8Message = message.toUtf8();
+        HandleMessage(context, utf8Message.constData(), utf8Message.size());
+    };
+
+    dispatchMessage(context, std::move(action));
 }
 
-void Server::handleResponse(
-    QWebSocket* connection,
-    std::unique_ptr<rtsp::Response>&& responsePtr) noexcept
+void Server::postMessage(ConnectionContext* context, const QByteArray& message) noexcept
 {
-    Session* session = connection->property("session").value<Session*>();
+    auto action = [context, message] () {
+        HandleMessage(context, message.constData(), message.size());
+    };
 
-    // it's better to use std::move_only_function here, but it's from too fresh c++23
-    _actor.postAction([owner = this, connection, session, response = responsePtr.release()] () {
-        if(!session->handleResponse(std::unique_ptr<rtsp::Response>(response))) {
-            qWarning() << "Failed to handle response. Forcing disconnect...";
-            QMetaObject::invokeMethod(
-                owner,
-                &Server::closeConnection,
-                connection);
-        }
-    });
+    dispatchMessage(context, std::move(action));
 }
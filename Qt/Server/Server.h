@@ -1,13 +1,14 @@
 #pragma once
 
-#include <map>
+#include <unordered_map>
+#include <vector>
 #include <memory>
 
 #include <QWebSocketServer>
 
 #include "RtStreaming/GstRtStreaming/LibGst.h"
 
-#include "../QActor.h"
+#include "../QActorPool.h"
 
 #include "Session.h"
 
@@ -31,45 +32,43 @@ protected:
     virtual void clientConnected(QWebSocket*) noexcept;
     virtual void clientDisconnected(QWebSocket*) noexcept;
 
+    // messages are parsed and handled on actor thread.
+    // Replies are sent the same way (text or binary) client sent its last message.
     virtual void textMessageReceived(QWebSocket*, const QString&) noexcept;
-    virtual void binaryMessageReceived(QWebSocket*, const QByteArray&) noexcept {}
+    virtual void binaryMessageReceived(QWebSocket*, const QByteArray&) noexcept;
 
     virtual void sendTextMessage(QWebSocket*, const QString&) noexcept;
     virtual void sendBinaryMessage(QWebSocket*, const QByteArray&) noexcept;
 
 private slots:
-    void sendMessage(QWebSocket*, const std::string& message) noexcept;
     // called after session referencing connection destroy
     void connectionOrphaned(QWebSocket*) noexcept;
 
 private:
-    static void SendMessage(
-        Server*,
-        QWebSocket* connection,
-        const std::string& message) noexcept;
-    static void SendRequest(
-        Server*,
-        QWebSocket* connection,
-        const rtsp::Request*) noexcept;
-    static void SendResponse(
-        Server*,
-        QWebSocket* connection,
-        const rtsp::Response*) noexcept;
-    static void CloseConnection(
-        Server*,
-        QWebSocket*) noexcept;
+    struct ConnectionContext;
+
+    // called from actor thread
+    static void HandleMessage(ConnectionContext*, const char* message, size_t size) noexcept;
+    static void SendRequest(ConnectionContext*, const rtsp::Request*) noexcept;
+    static void SendResponse(ConnectionContext*, const rtsp::Response*) noexcept;
+    static void QueueMessage(ConnectionContext*, std::string&& message) noexcept;
+    // should be called with locked ConnectionContext::outgoingGuard
+    static void ScheduleFlush(ConnectionContext*) noexcept;
+    static void RequestClose(ConnectionContext*) noexcept;
 
     void closeConnection(QWebSocket* connection) noexcept;
+    void flushOutgoing(QWebSocket*, ConnectionContext*) noexcept;
 
-    void handleRequest(QWebSocket*, std::unique_ptr<rtsp::Request>&&) noexcept;
-    void handleResponse(QWebSocket*, std::unique_ptr<rtsp::Response>&&) noexcept;
+    void dispatchMessage(ConnectionContext*, QActor::Action&&) noexcept;
+    void postMessage(ConnectionContext*, const QString&) noexcept;
+    void postMessage(ConnectionContext*, const QByteArray&) noexcept;
 
 private:
     const Config *const _config;
     const LibGst _libGst;
-    Session::SharedData _sharedData;
-    std::map<QWebSocket*, std::shared_ptr<Session>> _sessions;
-    QActor _actor;
+    std::vector<std::unique_ptr<Session::SharedData>> _sharedData; // per actor
+    std::unordered_map<QWebSocket*, std::shared_ptr<ConnectionContext>> _connections;
+    QActorPool _actors;
 };
 
 }
@@ -2,6 +2,7 @@
 
 #include "RtspParser/RtspParser.h"
 #include "RtspParser/RtspSerialize.h"
+#include "Metrics/Metrics.h"
 
 
 using namespace webrtsp::qt;
@@ -29,9 +30,19 @@ bool Session::handleRequest(std::unique_ptr<rtsp::Request>&& requestPtr) noexcep
     const std::pair<rtsp::Authentication, std::string> authPair =
         rtsp::ParseAuthentication(*requestPtr);
 
-    const bool authorized = _config->authToken.empty() ||
-        (authPair.first == rtsp::Authentication::Bearer &&
-        authPair.second == _config->authToken);
+    const bool isBearer = authPair.first == rtsp::Authentication::Bearer;
+    const bool signedTokenValid = isBearer &&
+        _config->authTokenSigner &&
+        _config->authTokenSigner->verify(authPair.second);
+    const bool authorized =
+        (_config->authToken.empty() && !_config->authTokenSigner) ||
+        (isBearer && !_config->authToken.empty() &&
+        auth::ConstantTimeEquals(authPair.second, _config->authToken)) ||
+        signedTokenValid;
+
+    // signed token can be limited to specific uris, so every request has to be checked
+    if(signedTokenValid)
+        setAuthTokenSigner(_config->authTokenSigner);
 
     _authorized = authorized;
 
@@ -43,6 +54,13 @@ bool Session::handleRequest(std::unique_ptr<rtsp::Request>&& requestPtr) noexcep
         return result;
     }
 
+    static metrics::Counter& authFailures =
+        metrics::Registry::Default().counter(
+            "webrtsp_auth_failures_total",
+            "Rejected authorization attempts",
+            { { "source", "qt" } });
+    authFailures.inc();
+
     return false;
 }
 
@@ -56,7 +74,29 @@ bool Session::onListRequest(std::unique_ptr<rtsp::Request>&& requestPtr) noexcep
     const std::string& uri = requestPtr->uri;
 
     if(uri == rtsp::WildcardUri) {
-        sendOkResponse(requestPtr->cseq, rtsp::TextParametersContentType, _sharedData->listCache);
+        // signed token can be limited to specific uris, so other streamers shouldn't be listed
+        rtsp::Parameters list;
+        if(!rtsp::ParseParameters(_sharedData->listCache, &list))
+            return false;
+
+        bool filtered = false;
+        for(auto it = list.begin(); it != list.end();) {
+            if(authTokenAllowsUri(it->first)) {
+                ++it;
+            } else {
+                it = list.erase(it);
+                filtered = true;
+            }
+        }
+
+        if(!filtered) {
+            sendOkResponse(requestPtr->cseq, rtsp::TextParametersContentType, _sharedData->listCache);
+        } else {
+            std::string body;
+            rtsp::Serialize(list, &body);
+            sendOkResponse(requestPtr->cseq, rtsp::TextParametersContentType, body);
+        }
+
         return true;
     }
 
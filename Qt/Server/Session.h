@@ -5,9 +5,8 @@
 #include <QObject>
 
 #include "RtspSession/ServerSession.h"
-#include "RtStreaming/GstRtStreaming/GstStreamingSource.h"
-
 #include "Config.h"
+#include "StreamerManager.h"
 
 
 namespace webrtsp::qt {
@@ -17,11 +16,9 @@ class Session : public QObject, public rtsp::ServerSession
     Q_OBJECT
 
 public:
-    typedef std::map<std::string, std::unique_ptr<GstStreamingSource>> Streamers;
-
     struct SharedData {
         const std::string listCache;
-        Streamers streamers;
+        StreamerManager streamers;
     };
 
     Session(
@@ -0,0 +1,392 @@
+#include "StreamerManager.h"
+
+#include <ctime>
+
+#include <QDebug>
+
+#include <CxxPtr/GlibPtr.h>
+
+#include "Metrics/Metrics.h"
+
+#include "RtStreaming/GstRtStreaming/GstReStreamer2.h"
+
+
+using namespace webrtsp::qt;
+
+namespace {
+
+enum {
+    PREWARM_CHECK_INTERVAL = 60, // seconds
+};
+
+metrics::Gauge& RunningStreamersGauge()
+{
+    static metrics::Gauge& gauge =
+        metrics::Registry::Default().gauge(
+            "webrtsp_streamers_running",
+            "Streamers connected to their sources");
+
+    return gauge;
+}
+
+const std::vector<double>& StartupBuckets() noexcept
+{
+    static const std::vector<double> buckets =
+        { 0.1, 0.25, 0.5, 1, 2, 3, 5, 7.5, 10, 15, 30 };
+
+    return buckets;
+}
+
+std::chrono::minutes LocalTimeOfDay() noexcept
+{
+    const std::time_t now = std::time(nullptr);
+    std::tm localNow {};
+    localtime_r(&now, &localNow);
+
+    return std::chrono::hours(localNow.tm_hour) + std::chrono::minutes(localNow.tm_min);
+}
+
+bool InWindow(const StreamerConfig::Window& window, std::chrono::minutes timeOfDay) noexcept
+{
+    if(window.begin <= window.end)
+        return timeOfDay >= window.begin && timeOfDay < window.end;
+    else
+        return timeOfDay >= window.begin || timeOfDay < window.end;
+}
+
+}
+
+struct StreamerManager::Private
+{
+    struct Entry;
+    class Lease;
+    class Peer;
+
+    Private(const std::map<std::string, StreamerConfig>&) noexcept;
+    ~Private();
+
+    bool keepWarm(const Entry&) const noexcept;
+    void update(Entry&) noexcept;
+    void startStreamer(Entry&) noexcept;
+    void stopStreamer(Entry&) noexcept;
+    void scheduleStop(Entry&) noexcept;
+    void checkPrewarm() noexcept;
+    void peerReleased(Entry&) noexcept;
+
+    GMainContextPtr contextPtr;
+    GSourcePtr prewarmSourcePtr;
+    std::map<std::string, Entry> entries;
+};
+
+struct StreamerManager::Private::Entry
+{
+    Entry(const std::string& name, const StreamerConfig& config) :
+        name(name),
+        config(config),
+        coldStartHistogram(
+            metrics::Registry::Default().histogram(
+                "webrtsp_streamer_peer_prepare_seconds",
+                "Time from peer creation to prepared peer",
+                StartupBuckets(),
+                { { "streamer", name }, { "start", "cold" } })),
+        warmStartHistogram(
+            metrics::Registry::Default().histogram(
+                "webrtsp_streamer_peer_prepare_seconds",
+                "Time from peer creation to prepared peer",
+                StartupBuckets(),
+                { { "streamer", name }, { "start", "warm" } }))
+        {}
+
+    const std::string name;
+    const StreamerConfig config;
+
+    metrics::Histogram& coldStartHistogram;
+    metrics::Histogram& warmStartHistogram;
+
+    std::unique_ptr<GstStreamingSource> streamer;
+    unsigned viewers = 0;
+    GSourcePtr lingerSourcePtr;
+};
+
+// keeps streamer running while alive
+class StreamerManager::Private::Lease
+{
+public:
+    Lease(Private* owner, Entry* entry, bool coldStart) :
+        _owner(owner), _entry(entry), _coldStart(coldStart),
+        _createdAt(std::chrono::steady_clock::now()) {}
+    ~Lease()
+        { _owner->peerReleased(*_entry); }
+
+    void prepared() noexcept;
+
+private:
+    Private *const _owner;
+    Entry *const _entry;
+    const bool _coldStart;
+    const std::chrono::steady_clock::time_point _createdAt;
+    bool _prepared = false;
+};
+
+void StreamerManager::Private::Lease::prepared() noexcept
+{
+    if(_prepared)
+        return;
+
+    _prepared = true;
+
+    const std::chrono::steady_clock::duration startup =
+        std::chrono::steady_clock::now() - _createdAt;
+    if(_coldStart) {
+        _entry->coldStartHistogram.observe(startup);
+        qInfo().noquote() <<
+            "Streamer" << QString::fromStdString(_entry->name) <<
+            "cold start took" <<
+            std::chrono::duration_cast<std::chrono::milliseconds>(startup).count() << "ms";
+    } else {
+        _entry->warmStartHistogram.observe(startup);
+    }
+}
+
+class StreamerManager::Private::Peer : public WebRTCPeer
+{
+public:
+    Peer(std::unique_ptr<Lease>&& lease, std::unique_ptr<WebRTCPeer>&& peer) :
+        _lease(std::move(lease)), _peer(std::move(peer)) {}
+
+    void prepare(
+        const WebRTCConfigPtr& webRTCConfig,
+        const PreparedCallback& prepared,
+        const IceCandidateCallback& iceCandidate,
+        const EosCallback& eos,
+        const std::string& logContext) noexcept override
+    {
+        Lease* lease = _lease.get();
+        _peer->prepare(
+            webRTCConfig,
+            [lease, prepared] () {
+                lease->prepared();
+                if(prepared)
+                    prepared();
+            },
+            iceCandidate,
+            eos,
+            logContext);
+    }
+
+    const std::string& sdp() noexcept override
+        { return _peer->sdp(); }
+
+    void setRemoteSdp(const std::string& sdp) noexcept override
+        { _peer->setRemoteSdp(sdp); }
+    void addIceCandidate(unsigned mlineIndex, const std::string& candidate) noexcept override
+        { _peer->addIceCandidate(mlineIndex, candidate); }
+
+    void play() noexcept override
+        { _peer->play(); }
+    void stop() noexcept override
+        { _peer->stop(); }
+
+private:
+    // wrapped peer has to be destroyed before lease since it can reference streamer
+    const std::unique_ptr<Lease> _lease;
+    const std::unique_ptr<WebRTCPeer> _peer;
+};
+
+StreamerManager::Private::Private(
+    const std::map<std::string, StreamerConfig>& streamers) noexcept
+{
+    for(const auto& pair: streamers)
+        entries.emplace(
+            std::piecewise_construct,
+            std::forward_as_tuple(pair.first),
+            std::forward_as_tuple(pair.first, pair.second));
+}
+
+StreamerManager::Private::~Private()
+{
+    if(prewarmSourcePtr)
+        g_source_destroy(prewarmSourcePtr.get());
+
+    for(auto& pair: entries) {
+        Entry& entry = pair.second;
+        if(entry.lingerSourcePtr)
+            g_source_destroy(entry.lingerSourcePtr.get());
+        if(entry.streamer)
+            RunningStreamersGauge().dec();
+    }
+}
+
+bool StreamerManager::Private::keepWarm(const Entry& entry) const noexcept
+{
+    switch(entry.config.policy) {
+    case StreamerConfig::Policy::AlwaysOn:
+        return true;
+    case StreamerConfig::Policy::OnDemand:
+        return false;
+    case StreamerConfig::Policy::Prewarm: {
+        const std::chrono::minutes timeOfDay = LocalTimeOfDay();
+        for(const StreamerConfig::Window& window: entry.config.prewarmWindows) {
+            if(InWindow(window, timeOfDay))
+                return true;
+        }
+        return false;
+    }
+    }
+
+    return false;
+}
+
+void StreamerManager::Private::update(Entry& entry) noexcept
+{
+    if(entry.viewers > 0 || keepWarm(entry)) {
+        if(entry.lingerSourcePtr) {
+            g_source_destroy(entry.lingerSourcePtr.get());
+            entry.lingerSourcePtr.reset();
+        }
+        if(!entry.streamer)
+            startStreamer(entry);
+    } else if(entry.streamer && !entry.lingerSourcePtr) {
+        scheduleStop(entry);
+    }
+}
+
+void StreamerManager::Private::startStreamer(Entry& entry) noexcept
+{
+    switch(entry.config.type) {
+    case StreamerConfig::Type::ReStreamer:
+        entry.streamer =
+            std::make_unique<GstReStreamer2>(
+                entry.config.uri,
+                entry.config.forceH264ProfileLevelId);
+        break;
+    }
+
+    if(entry.streamer) {
+        RunningStreamersGauge().inc();
+        qInfo().noquote() << "Streamer" << QString::fromStdString(entry.name) << "started";
+    }
+}
+
+void StreamerManager::Private::stopStreamer(Entry& entry) noexcept
+{
+    if(!entry.streamer)
+        return;
+
+    entry.streamer.reset();
+    RunningStreamersGauge().dec();
+    qInfo().noquote() << "Streamer" << QString::fromStdString(entry.name) << "stopped";
+}
+
+void StreamerManager::Private::scheduleStop(Entry& entry) noexcept
+{
+    if(entry.config.linger.count() <= 0 || !contextPtr) {
+        stopStreamer(entry);
+        return;
+    }
+
+    entry.lingerSourcePtr.reset(g_timeout_source_new_seconds(entry.config.linger.count()));
+    GSource* lingerSource = entry.lingerSourcePtr.get();
+
+    struct CallbackData {
+        Private* owner;
+        Entry* entry;
+    };
+    g_source_set_callback(
+        lingerSource,
+        [] (gpointer userData) -> gboolean {
+            const CallbackData* callbackData = static_cast<CallbackData*>(userData);
+            Entry& entry = *callbackData->entry;
+
+            entry.lingerSourcePtr.reset();
+            if(entry.viewers == 0 && !callbackData->owner->keepWarm(entry))
+                callbackData->owner->stopStreamer(entry);
+
+            return G_SOURCE_REMOVE;
+        },
+        new CallbackData { this, &entry },
+        [] (gpointer userData) {
+            delete static_cast<CallbackData*>(userData);
+        });
+    g_source_attach(lingerSource, contextPtr.get());
+}
+
+void StreamerManager::Private::checkPrewarm() noexcept
+{
+    for(auto& pair: entries) {
+        Entry& entry = pair.second;
+        if(entry.config.policy == StreamerConfig::Policy::Prewarm)
+            update(entry);
+    }
+}
+
+void StreamerManager::Private::peerReleased(Entry& entry) noexcept
+{
+    if(entry.viewers > 0)
+        --entry.viewers;
+
+    update(entry);
+}
+
+StreamerManager::StreamerManager(
+    const std::map<std::string, StreamerConfig>& streamers) noexcept :
+    _p(std::make_unique<Private>(streamers))
+{
+}
+
+StreamerManager::~StreamerManager()
+{
+}
+
+void StreamerManager::start() noexcept
+{
+    if(_p->contextPtr)
+        return;
+
+    _p->contextPtr.reset(g_main_context_ref_thread_default());
+
+    bool hasPrewarm = false;
+    for(auto& pair: _p->entries) {
+        Private::Entry& entry = pair.second;
+        hasPrewarm = hasPrewarm || entry.config.policy == StreamerConfig::Policy::Prewarm;
+        _p->update(entry);
+    }
+
+    if(!hasPrewarm)
+        return;
+
+    _p->prewarmSourcePtr.reset(g_timeout_source_new_seconds(PREWARM_CHECK_INTERVAL));
+    GSource* prewarmSource = _p->prewarmSourcePtr.get();
+    g_source_set_callback(
+        prewarmSource,
+        [] (gpointer userData) -> gboolean {
+            static_cast<Private*>(userData)->checkPrewarm();
+            return G_SOURCE_CONTINUE;
+        },
+        _p.get(),
+        nullptr);
+    g_source_attach(prewarmSource, _p->contextPtr.get());
+}
+
+std::unique_ptr<WebRTCPeer> StreamerManager::createPeer(const std::string& uri) noexcept
+{
+    auto it = _p->entries.find(uri);
+    if(it == _p->entries.end())
+        return nullptr;
+
+    Private::Entry& entry = it->second;
+
+    const bool coldStart = !entry.streamer;
+    ++entry.viewers;
+    _p->update(entry);
+
+    std::unique_ptr<Private::Lease> lease =
+        std::make_unique<Private::Lease>(_p.get(), &entry, coldStart);
+
+    std::unique_ptr<WebRTCPeer> peer =
+        entry.streamer ? entry.streamer->createPeer() : nullptr;
+    if(!peer)
+        return nullptr; // lease releases viewer
+
+    return std::make_unique<Private::Peer>(std::move(lease), std::move(peer));
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <glib.h>
+
+#include "RtStreaming/WebRTCPeer.h"
+
+#include "Config.h"
+
+
+namespace webrtsp::qt {
+
+// Owns streamers of single actor thread and starts/stops them according to StreamerConfig::Policy.
+// Every returned peer is counted as viewer of it's streamer until destroyed.
+class StreamerManager
+{
+public:
+    explicit StreamerManager(const std::map<std::string, StreamerConfig>&) noexcept;
+    ~StreamerManager();
+
+    // should be called on actor thread before first createPeer,
+    // timers are attached to thread default GMainContext
+    void start() noexcept;
+
+    std::unique_ptr<WebRTCPeer> createPeer(const std::string& uri) noexcept;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> _p;
+};
+
+}
@@ -23,5 +23,8 @@ const char *const TextListContentType = "text/list";
 const char *const TextParametersContentType = "text/parameters";
 const char *const SdpContentType = "application/sdp";
 const char *const IceCandidateContentType = "application/x-ice-candidate";
+// aggregate DESCRIBE: request body is uri list, response body is one part per requested uri
+const char *const UriListContentType = "text/uri-list";
+const char *const MediaDescriptionsContentType = "multipart/mixed; boundary=webrtsp-part";
 
 }
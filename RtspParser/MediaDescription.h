@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common.h"
+
+
+namespace rtsp {
+
+// single part of aggregate DESCRIBE response
+struct MediaDescription {
+    std::string uri;
+    unsigned statusCode;
+    MediaSessionId session; // empty if statusCode is not OK
+    std::string sdp;
+};
+
+typedef std::vector<MediaDescription> MediaDescriptions;
+
+}
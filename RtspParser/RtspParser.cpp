@@ -578,6 +578,87 @@ bool ParseParametersNames(
 
 }
 
+bool ParseUriList(
+    const std::string& body,
+    std::vector<std::string>* uris) noexcept
+{
+    const char* buf = body.data();
+    size_t size = body.size();
+    size_t pos = 0;
+
+    while(!IsEOS(pos, size)) {
+        const Token uri = GetURI(buf, &pos, size);
+        if(IsEmptyToken(uri))
+            return false;
+
+        uris->emplace_back(uri.token, uri.size);
+
+        if(!SkipEOL(buf, &pos, size))
+            return false;
+    }
+
+    return true;
+}
+
+static const char PartDelimiter[] = "--webrtsp-part";
+static const char BodyPartDelimiter[] = "\r\n--webrtsp-part";
+
+bool ParseMediaDescriptions(
+    const std::string& body,
+    MediaDescriptions* descriptions) noexcept
+{
+    const char* buf = body.data();
+    size_t size = body.size();
+    size_t pos = 0;
+
+    if(body.compare(0, sizeof(PartDelimiter) - 1, PartDelimiter) != 0)
+        return false;
+    pos += sizeof(PartDelimiter) - 1;
+
+    for(;;) {
+        if(IsChar(buf, pos, size, '-') && IsChar(buf, pos + 1, size, '-'))
+            return true; // close delimiter
+
+        if(!SkipEOL(buf, &pos, size))
+            return false;
+
+        std::map<std::string, std::string, LessNoCase> headerFields;
+        while(!SkipEOL(buf, &pos, size)) {
+            if(!ParseHeaderField(buf, &pos, size, &headerFields))
+                return false;
+        }
+
+        const std::string::size_type delimiterPos = body.find(BodyPartDelimiter, pos);
+        if(delimiterPos == std::string::npos)
+            return false;
+
+        MediaDescription description {};
+
+        auto uriIt = headerFields.find("content-location");
+        if(uriIt == headerFields.end() || uriIt->second.empty())
+            return false;
+        description.uri = uriIt->second;
+
+        auto statusIt = headerFields.find("status");
+        if(statusIt == headerFields.end() || statusIt->second.size() != 3)
+            return false;
+        size_t statusPos = 0;
+        description.statusCode =
+            ParseStatusCode(GetStatusCode(statusIt->second.data(), &statusPos, 3));
+        if(!description.statusCode)
+            return false;
+
+        if(auto sessionIt = headerFields.find("session"); sessionIt != headerFields.end())
+            description.session = sessionIt->second;
+
+        description.sdp.assign(buf + pos, delimiterPos - pos);
+
+        descriptions->emplace_back(std::move(description));
+
+        pos = delimiterPos + sizeof(BodyPartDelimiter) - 1;
+    }
+}
+
 std::set<rtsp::Method> ParseOptions(const Response& response)
 {
     std::set<rtsp::Method> returnOptions;
@@ -6,6 +6,7 @@
 #include "Request.h"
 #include "Response.h"
 #include "Authentication.h"
+#include "MediaDescription.h"
 
 
 namespace rtsp {
@@ -25,6 +26,14 @@ bool ParseParametersNames(
     const std::string& body,
     ParametersNames*) noexcept;
 
+bool ParseUriList(
+    const std::string& body,
+    std::vector<std::string>*) noexcept;
+
+bool ParseMediaDescriptions(
+    const std::string& body,
+    MediaDescriptions*) noexcept;
+
 std::set<rtsp::Method> ParseOptions(const Response&);
 std::optional<std::pair<unsigned, std::string>> ParseIceCandidate(const std::string& iceCandidate);
 
@@ -38,6 +38,56 @@ void Serialize(const Parameters& parameters, std::string* out) noexcept
     }
 }
 
+void Serialize(const std::vector<std::string>& uriList, std::string* out) noexcept
+{
+    out->clear();
+
+    for(const std::string& uri: uriList) {
+        *out += uri;
+        *out += "\r\n";
+    }
+}
+
+void Serialize(const MediaDescriptions& descriptions, std::string* out) noexcept
+{
+    try {
+        *out = "--webrtsp-part";
+
+        for(const MediaDescription& description: descriptions) {
+            *out += "\r\n";
+
+            *out += "Content-Location: ";
+            *out += description.uri;
+            *out += "\r\n";
+
+            *out += "Status: ";
+            SerializeStatusCode(description.statusCode, out);
+            *out += "\r\n";
+
+            if(!description.session.empty()) {
+                *out += "Session: ";
+                *out += description.session;
+                *out += "\r\n";
+            }
+
+            if(!description.sdp.empty()) {
+                *out += ContentTypeFieldName;
+                *out += ": ";
+                *out += SdpContentType;
+                *out += "\r\n";
+            }
+
+            *out += "\r\n";
+            *out += description.sdp;
+            *out += "\r\n--webrtsp-part";
+        }
+
+        *out += "--\r\n";
+    } catch(...) {
+        out->clear();
+    }
+}
+
 void Serialize(const Request& request, std::string* out) noexcept
 {
     try {
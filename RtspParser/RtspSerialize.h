@@ -2,11 +2,14 @@
 
 #include "Request.h"
 #include "Response.h"
+#include "MediaDescription.h"
 
 
 namespace rtsp {
 
 void Serialize(const Parameters&, std::string* out) noexcept;
+void Serialize(const std::vector<std::string>& uriList, std::string* out) noexcept;
+void Serialize(const MediaDescriptions&, std::string* out) noexcept;
 
 void Serialize(const Request&, std::string* out) noexcept;
 std::string Serialize(const Request&) noexcept;
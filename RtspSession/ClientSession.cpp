@@ -52,6 +52,7 @@ struct ClientSession::Private
     MediaSessionId session;
     CSeq recordRequestCSeq = InvalidCSeq;
 
+    bool receive(const MediaSessionId&, const std::string& sdp);
     void receiverPrepared();
     void iceCandidate(unsigned, const std::string&);
     void eos();
@@ -65,6 +66,39 @@ ClientSession::Private::Private(
 {
 }
 
+bool ClientSession::Private::receive(
+    const MediaSessionId& mediaSession,
+    const std::string& sdp)
+{
+    assert(session.empty());
+
+    session = mediaSession;
+    if(session.empty())
+        return false;
+
+    if(sdp.empty())
+        return false;
+
+    receiver->prepare(
+        owner->webRTCConfig(),
+        std::bind(
+            &ClientSession::Private::receiverPrepared,
+            this),
+        std::bind(
+            &ClientSession::Private::iceCandidate,
+            this,
+            std::placeholders::_1,
+            std::placeholders::_2),
+        std::bind(
+            &ClientSession::Private::eos,
+            this),
+        owner->sessionLogId);
+
+    receiver->setRemoteSdp(sdp);
+
+    return true;
+}
+
 void ClientSession::Private::receiverPrepared()
 {
     if(receiver->sdp().empty()) {
@@ -150,6 +184,11 @@ CSeq ClientSession::requestDescribe() noexcept
     return Session::requestDescribe(_p->uri);
 }
 
+CSeq ClientSession::requestDescribe(const std::vector<std::string>& uris) noexcept
+{
+    return Session::requestDescribe(uris);
+}
+
 CSeq ClientSession::requestSubscribe() noexcept
 {
     assert(!_p->uri.empty());
@@ -192,32 +231,35 @@ bool ClientSession::onDescribeResponse(
     if(StatusCode::OK != response.statusCode)
         return false;
 
-    assert(_p->session.empty());
+    if(ResponseContentType(response) == MediaDescriptionsContentType) {
+        MediaDescriptions descriptions;
+        if(!ParseMediaDescriptions(response.body, &descriptions))
+            return false;
 
-    _p->session = ResponseSession(response);
-    if(_p->session.empty())
-        return false;
+        for(const MediaDescription& description: descriptions) {
+            if(!onMediaDescription(request, description))
+                return false;
+        }
 
-    const std::string& sdp = response.body;
-    if(sdp.empty())
-        return false;
+        return true;
+    }
 
-    _p->receiver->prepare(
-        webRTCConfig(),
-        std::bind(
-            &ClientSession::Private::receiverPrepared,
-            _p.get()),
-        std::bind(
-            &ClientSession::Private::iceCandidate,
-            _p.get(),
-            std::placeholders::_1,
-            std::placeholders::_2),
-        std::bind(
-            &ClientSession::Private::eos,
-            _p.get()),
-        sessionLogId);
+    return _p->receive(ResponseSession(response), response.body);
+}
 
-    _p->receiver->setRemoteSdp(sdp);
+bool ClientSession::onMediaDescription(
+    const Request&,
+    const MediaDescription& description) noexcept
+{
+    if(description.uri == _p->uri && _p->session.empty()) {
+        if(StatusCode::OK != description.statusCode)
+            return false;
+
+        return _p->receive(description.session, description.sdp);
+    }
+
+    if(StatusCode::OK == description.statusCode)
+        requestTeardown(description.uri, description.session);
 
     return true;
 }
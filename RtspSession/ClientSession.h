@@ -1,6 +1,7 @@
 #pragma once
 
 #include "RtStreaming/WebRTCPeer.h"
+#include "RtspParser/MediaDescription.h"
 #include "Session.h"
 
 
@@ -39,8 +40,13 @@ protected:
         { return FeatureState::Disabled; }
 
     CSeq requestDescribe() noexcept;
+    // aggregate DESCRIBE, every part of response is passed to onMediaDescription
+    CSeq requestDescribe(const std::vector<std::string>& uris) noexcept;
     CSeq requestSubscribe() noexcept;
 
+    // default implementation plays part matching session uri and tears down others
+    virtual bool onMediaDescription(const Request&, const MediaDescription&) noexcept;
+
     bool onOptionsResponse(
         const Request&, const Response&) noexcept override;
     bool onDescribeResponse(
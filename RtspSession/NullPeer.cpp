@@ -0,0 +1,234 @@
+#include "NullPeer.h"
+
+#include <cassert>
+#include <atomic>
+
+#include <glib.h>
+
+
+namespace rtsp {
+
+namespace {
+
+const char *const Fingerprint =
+    "00:00:00:00:00:00:00:00:00:00:00:00:00:00:00:00:"
+    "00:00:00:00:00:00:00:00:00:00:00:00:00:00:00:00";
+
+std::string MakeSdp(unsigned peerId, bool answer)
+{
+    const std::string id = std::to_string(peerId);
+
+    std::string sdp;
+    sdp += "v=0\r\n";
+    sdp += "o=- " + id + " 0 IN IP4 0.0.0.0\r\n";
+    sdp += "s=-\r\n";
+    sdp += "t=0 0\r\n";
+    sdp += "a=group:BUNDLE video0\r\n";
+    sdp += "a=ice-options:trickle\r\n";
+    sdp += "m=video 9 UDP/TLS/RTP/SAVPF 96\r\n";
+    sdp += "c=IN IP4 0.0.0.0\r\n";
+    sdp += answer ? "a=setup:active\r\n" : "a=setup:actpass\r\n";
+    sdp += "a=ice-ufrag:null" + id + "\r\n";
+    sdp += "a=ice-pwd:nullpeernullpeernullpeer\r\n";
+    sdp += std::string("a=fingerprint:sha-256 ") + Fingerprint + "\r\n";
+    sdp += "a=mid:video0\r\n";
+    sdp += answer ? "a=recvonly\r\n" : "a=sendonly\r\n";
+    sdp += "a=rtcp-mux\r\n";
+    sdp += "a=rtpmap:96 H264/90000\r\n";
+    sdp += "a=fmtp:96 packetization-mode=1;profile-level-id=42e01f\r\n";
+
+    return sdp;
+}
+
+std::string MakeIceCandidate(unsigned peerId, unsigned index)
+{
+    return
+        "candidate:" + std::to_string(index + 1) + " 1 UDP 2122252543 127.0.0.1 " +
+        std::to_string(10000 + (peerId * 8 + index) % 50000) + " typ host";
+}
+
+}
+
+struct NullPeer::Private
+{
+    Private(const Config&, const Schedule&);
+
+    const Config config;
+    const Schedule schedule;
+    const unsigned id;
+
+    PreparedCallback prepared;
+    IceCandidateCallback iceCandidate;
+    EosCallback eos;
+
+    std::string sdp;
+    std::string remoteSdp;
+    unsigned remoteIceCandidates = 0;
+
+    bool preparing = false;
+    bool playing = false;
+
+    static void OnPrepared(const std::weak_ptr<Private>&);
+    static void OnIceCandidate(const std::weak_ptr<Private>&, unsigned index);
+    static void OnEos(const std::weak_ptr<Private>&);
+};
+
+NullPeer::Private::Private(const Config& config, const Schedule& schedule) :
+    config(config),
+    schedule(schedule),
+    id([] () {
+        static std::atomic<unsigned> nextId = 0;
+        return nextId++;
+    } ())
+{
+}
+
+void NullPeer::Private::OnPrepared(const std::weak_ptr<Private>& weakSelf)
+{
+    std::shared_ptr<Private> self = weakSelf.lock();
+    if(!self || !self->preparing)
+        return;
+
+    self->preparing = false;
+    self->sdp = MakeSdp(self->id, !self->remoteSdp.empty());
+
+    if(self->prepared)
+        self->prepared();
+}
+
+void NullPeer::Private::OnIceCandidate(const std::weak_ptr<Private>& weakSelf, unsigned index)
+{
+    std::shared_ptr<Private> self = weakSelf.lock();
+    if(!self)
+        return;
+
+    if(self->iceCandidate)
+        self->iceCandidate(0, MakeIceCandidate(self->id, index));
+}
+
+void NullPeer::Private::OnEos(const std::weak_ptr<Private>& weakSelf)
+{
+    std::shared_ptr<Private> self = weakSelf.lock();
+    if(!self || !self->playing)
+        return;
+
+    self->playing = false;
+
+    if(self->eos)
+        self->eos();
+}
+
+
+NullPeer::Schedule NullPeer::GlibSchedule() noexcept
+{
+    return [] (std::chrono::milliseconds delay, const Action& action) {
+        GSource* source = delay.count() > 0 ?
+            g_timeout_source_new(delay.count()) :
+            g_idle_source_new();
+        g_source_set_callback(
+            source,
+            [] (gpointer userData) -> gboolean {
+                (*static_cast<Action*>(userData))();
+                return G_SOURCE_REMOVE;
+            },
+            new Action(action),
+            [] (gpointer userData) {
+                delete static_cast<Action*>(userData);
+            });
+        g_source_attach(source, g_main_context_get_thread_default());
+        g_source_unref(source);
+    };
+}
+
+NullPeer::NullPeer() noexcept :
+    NullPeer(Config())
+{
+}
+
+NullPeer::NullPeer(const Config& config, const Schedule& schedule) noexcept :
+    _p(std::make_shared<Private>(config, schedule))
+{
+}
+
+NullPeer::~NullPeer()
+{
+}
+
+void NullPeer::prepare(
+    const WebRTCConfigPtr&,
+    const PreparedCallback& prepared,
+    const IceCandidateCallback& iceCandidate,
+    const EosCallback& eos,
+    const std::string& /*logContext*/) noexcept
+{
+    assert(!_p->preparing && _p->sdp.empty());
+    if(_p->preparing || !_p->sdp.empty())
+        return;
+
+    _p->prepared = prepared;
+    _p->iceCandidate = iceCandidate;
+    _p->eos = eos;
+    _p->preparing = true;
+
+    std::weak_ptr<Private> weakPrivate = _p;
+
+    _p->schedule(
+        _p->config.prepareDelay,
+        std::bind(&Private::OnPrepared, weakPrivate));
+
+    for(unsigned i = 0; i < _p->config.iceCandidates; ++i) {
+        _p->schedule(
+            _p->config.iceCandidateInterval * (i + 1),
+            std::bind(&Private::OnIceCandidate, weakPrivate, i));
+    }
+}
+
+const std::string& NullPeer::sdp() noexcept
+{
+    return _p->sdp;
+}
+
+void NullPeer::setRemoteSdp(const std::string& sdp) noexcept
+{
+    _p->remoteSdp = sdp;
+}
+
+void NullPeer::addIceCandidate(
+    unsigned /*mlineIndex*/,
+    const std::string& /*candidate*/) noexcept
+{
+    ++_p->remoteIceCandidates;
+}
+
+void NullPeer::play() noexcept
+{
+    if(_p->playing)
+        return;
+
+    _p->playing = true;
+
+    if(_p->config.eosAfterPlay) {
+        std::weak_ptr<Private> weakPrivate = _p;
+        _p->schedule(
+            _p->config.eosAfterPlay.value(),
+            std::bind(&Private::OnEos, weakPrivate));
+    }
+}
+
+void NullPeer::stop() noexcept
+{
+    _p->preparing = false;
+    _p->playing = false;
+}
+
+const std::string& NullPeer::remoteSdp() const noexcept
+{
+    return _p->remoteSdp;
+}
+
+unsigned NullPeer::remoteIceCandidates() const noexcept
+{
+    return _p->remoteIceCandidates;
+}
+
+}
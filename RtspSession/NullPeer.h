@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+
+#include "RtStreaming/WebRTCPeer.h"
+
+
+namespace rtsp {
+
+// WebRTCPeer without any media pipeline behind it.
+// Produces canned SDP offer (or answer if remote SDP was set before prepare completes),
+// emits synthetic ICE candidates and optional EOS on configurable schedule.
+// Intended for signalling tests and benchmarks.
+class NullPeer : public WebRTCPeer
+{
+public:
+    typedef std::function<void ()> Action;
+    typedef std::function<void (std::chrono::milliseconds delay, const Action&)> Schedule;
+
+    struct Config
+    {
+        std::chrono::milliseconds prepareDelay = std::chrono::milliseconds(0);
+        unsigned iceCandidates = 2;
+        std::chrono::milliseconds iceCandidateInterval = std::chrono::milliseconds(0);
+        std::optional<std::chrono::milliseconds> eosAfterPlay;
+    };
+
+    // default schedule uses thread default GMainContext
+    static Schedule GlibSchedule() noexcept;
+
+    NullPeer() noexcept;
+    explicit NullPeer(const Config&, const Schedule& = GlibSchedule()) noexcept;
+    ~NullPeer();
+
+    void prepare(
+        const WebRTCConfigPtr&,
+        const PreparedCallback&,
+        const IceCandidateCallback&,
+        const EosCallback&,
+        const std::string& logContext) noexcept override;
+
+    const std::string& sdp() noexcept override;
+
+    void setRemoteSdp(const std::string& sdp) noexcept override;
+    void addIceCandidate(
+        unsigned mlineIndex,
+        const std::string& candidate) noexcept override;
+
+    void play() noexcept override;
+    void stop() noexcept override;
+
+    const std::string& remoteSdp() const noexcept;
+    unsigned remoteIceCandidates() const noexcept;
+
+private:
+    struct Private;
+    std::shared_ptr<Private> _p;
+};
+
+}
@@ -0,0 +1,100 @@
+#include "ScriptedClientSession.h"
+
+
+namespace rtsp {
+
+ScriptedClientSession::ScriptedClientSession(
+    const std::string& uri,
+    const Script& script,
+    const Schedule& schedule,
+    const CycleCompleted& cycleCompleted,
+    const WebRTCConfigPtr& webRTCConfig,
+    const CreatePeer& createPeer,
+    const SendRequest& sendRequest,
+    const SendResponse& sendResponse) noexcept :
+    ClientSession(uri, webRTCConfig, createPeer, sendRequest, sendResponse),
+    _uri(uri),
+    _script(script),
+    _schedule(schedule),
+    _cycleCompleted(cycleCompleted),
+    _self(std::make_shared<ScriptedClientSession*>(this))
+{
+}
+
+bool ScriptedClientSession::onDescribeResponse(
+    const Request& request,
+    const Response& response) noexcept
+{
+    if(!ClientSession::onDescribeResponse(request, response))
+        return false;
+
+    _mediaSession = ResponseSession(response);
+
+    return true;
+}
+
+bool ScriptedClientSession::onPlayResponse(
+    const Request& request,
+    const Response& response) noexcept
+{
+    if(!ClientSession::onPlayResponse(request, response))
+        return false;
+
+    schedulePing();
+
+    return true;
+}
+
+bool ScriptedClientSession::onGetParameterResponse(
+    const Request&,
+    const Response& response) noexcept
+{
+    if(StatusCode::OK != response.statusCode)
+        return false;
+
+    schedulePing();
+
+    return true;
+}
+
+bool ScriptedClientSession::onTeardownResponse(
+    const Request&,
+    const Response& response) noexcept
+{
+    if(StatusCode::OK != response.statusCode)
+        return false;
+
+    if(ResponseSession(response) != _mediaSession)
+        return false;
+
+    if(_cycleCompleted)
+        _cycleCompleted();
+
+    disconnect();
+
+    return true;
+}
+
+void ScriptedClientSession::schedulePing() noexcept
+{
+    if(_pingsSent >= _script.pings) {
+        requestTeardown(_uri, _mediaSession);
+        return;
+    }
+
+    _schedule(
+        _script.pingInterval,
+        [weakSelf = weakSelf()] () {
+            if(std::shared_ptr<ScriptedClientSession*> self = weakSelf.lock())
+                (*self)->ping();
+        });
+}
+
+void ScriptedClientSession::ping() noexcept
+{
+    ++_pingsSent;
+
+    requestGetParameter(_uri, std::string(), std::string());
+}
+
+}
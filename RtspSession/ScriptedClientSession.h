@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "ClientSession.h"
+#include "NullPeer.h"
+
+
+namespace rtsp {
+
+// Drives single scripted cycle per connection:
+// OPTIONS -> DESCRIBE -> SETUP(s) -> PLAY -> GET_PARAMETER x N -> TEARDOWN
+// Timers go through Schedule, so the same script runs on real or virtual clock.
+// Intended for load tests and simulations.
+class ScriptedClientSession : public ClientSession
+{
+public:
+    typedef NullPeer::Schedule Schedule;
+    typedef std::function<void ()> CycleCompleted;
+
+    struct Script
+    {
+        unsigned pings;
+        std::chrono::milliseconds pingInterval;
+    };
+
+    ScriptedClientSession(
+        const std::string& uri,
+        const Script&,
+        const Schedule&,
+        const CycleCompleted&,
+        const WebRTCConfigPtr&,
+        const CreatePeer& createPeer,
+        const SendRequest& sendRequest,
+        const SendResponse& sendResponse) noexcept;
+
+protected:
+    // expires with session, so scheduled actions can check session is still alive
+    std::weak_ptr<ScriptedClientSession*> weakSelf() const noexcept
+        { return _self; }
+
+    bool onDescribeResponse(
+        const Request&, const Response&) noexcept override;
+    bool onPlayResponse(
+        const Request&, const Response&) noexcept override;
+    bool onGetParameterResponse(
+        const Request&, const Response&) noexcept override;
+    bool onTeardownResponse(
+        const Request&, const Response&) noexcept override;
+
+private:
+    void schedulePing() noexcept;
+    void ping() noexcept;
+
+private:
+    const std::string _uri;
+    const Script _script;
+    const Schedule _schedule;
+    const CycleCompleted _cycleCompleted;
+
+    const std::shared_ptr<ScriptedClientSession*> _self;
+
+    MediaSessionId _mediaSession;
+    unsigned _pingsSent = 0;
+};
+
+}
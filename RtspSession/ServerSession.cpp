@@ -3,9 +3,15 @@
 #include <list>
 #include <map>
 
+#include "RtspParser/RtspParser.h"
+#include "RtspParser/RtspSerialize.h"
+
 #include "RtspSession/StatusCode.h"
 #include "RtspSession/IceCandidate.h"
 
+#include "Metrics/Metrics.h"
+#include "Metrics/Trace.h"
+
 #include "Log.h"
 
 
@@ -13,6 +19,40 @@ namespace rtsp {
 
 namespace {
 
+enum {
+    MAX_AGGREGATE_URIS = 64,
+};
+
+bool IsAggregateDescribe(const Request& request)
+{
+    return
+        request.method == Method::DESCRIBE &&
+        request.uri == WildcardUri &&
+        RequestContentType(request) == UriListContentType;
+}
+
+metrics::Counter& AuthFailuresCounter()
+{
+    static metrics::Counter& counter =
+        metrics::Registry::Default().counter(
+            "webrtsp_auth_failures_total",
+            "Rejected authorization attempts",
+            { { "source", "rtsp" } });
+
+    return counter;
+}
+
+metrics::Histogram& PeerPrepareHistogram()
+{
+    static metrics::Histogram& histogram =
+        metrics::Registry::Default().histogram(
+            "webrtsp_peer_prepare_seconds",
+            "Time from media session creation to local peer prepared",
+            metrics::LatencyBuckets());
+
+    return histogram;
+}
+
 struct MediaSession
 {
     enum class Type {
@@ -21,19 +61,59 @@ struct MediaSession
         Subscribe,
     };
 
+    static metrics::Gauge& ActiveGauge(Type type)
+    {
+        static metrics::Gauge* gauges[] = {
+            &metrics::Registry::Default().gauge(
+                "webrtsp_media_sessions", "Live media sessions", { { "type", "describe" } }),
+            &metrics::Registry::Default().gauge(
+                "webrtsp_media_sessions", "Live media sessions", { { "type", "record" } }),
+            &metrics::Registry::Default().gauge(
+                "webrtsp_media_sessions", "Live media sessions", { { "type", "subscribe" } }),
+        };
+
+        return *gauges[static_cast<unsigned>(type)];
+    }
+
     MediaSession(MediaSession::Type type, const std::string& uri, CSeq initialRequestCSeq) :
-        type(type), uri(uri), initialRequestCSeq(initialRequestCSeq) {}
+        type(type), uri(uri), initialRequestCSeq(initialRequestCSeq)
+        { ActiveGauge(type).inc(); }
+    ~MediaSession()
+        { ActiveGauge(type).dec(); }
+
+    void observePrepared(const std::string& sessionLogId, const MediaSessionId& session)
+    {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        PeerPrepareHistogram().observe(now - createdAt);
+        metrics::trace::Complete("prepare", sessionLogId, session, createdAt, now);
+    }
+    void onPrepared(const std::string& sessionLogId, const MediaSessionId& session)
+    {
+        prepared = true;
+        observePrepared(sessionLogId, session);
+    }
 
     const Type type;
     const std::string uri;
     const CSeq initialRequestCSeq;
+    const std::chrono::steady_clock::time_point createdAt = std::chrono::steady_clock::now();
     std::unique_ptr<WebRTCPeer> localPeer;
     std::deque<IceCandidate> iceCandidates;
     bool prepared = false;
+    std::optional<size_t> aggregatePart; // index of part in aggregate DESCRIBE response
 };
 
 typedef std::map<MediaSessionId, std::unique_ptr<MediaSession>> MediaSessions;
 
+// aggregate DESCRIBE is answered once all it's media sessions got prepared or failed
+struct AggregateDescribe
+{
+    MediaDescriptions parts; // statusCode is 0 while part is not prepared yet
+    unsigned pending = 0;
+};
+
+typedef std::map<CSeq, AggregateDescribe> AggregateDescribes;
+
 }
 
 struct ServerSession::Private
@@ -56,7 +136,11 @@ struct ServerSession::Private
 
     std::optional<std::string> authCookie;
 
+    std::shared_ptr<const auth::TokenSigner> authTokenSigner;
+    std::optional<std::string> authToken; // last Bearer token got from client
+
     MediaSessions mediaSessions;
+    AggregateDescribes aggregateDescribes;
 
     bool recordEnabled()
         { return createRecordPeer ? true : false; }
@@ -65,6 +149,10 @@ struct ServerSession::Private
         { return std::to_string(_nextSessionId++); }
 
     void sendIceCandidates(const MediaSessionId&, MediaSession* mediaSession);
+    void prepareStreamer(const MediaSessionId&, MediaSession*);
+    bool aggregateDescribe(std::unique_ptr<Request>&&);
+    void aggregatePartDone(const MediaSession&, unsigned statusCode);
+    void sendAggregateResponse(CSeq);
     void streamerPrepared(const MediaSessionId&);
     void recorderPrepared(const MediaSessionId&);
     void recordToClientStreamerPrepared(const MediaSessionId&);
@@ -130,7 +218,22 @@ void ServerSession::Private::streamerPrepared(const MediaSessionId& session)
     WebRTCPeer& localPeer = *mediaSession.localPeer;
     const CSeq describeRequestCSeq = mediaSession.initialRequestCSeq;
 
-    mediaSession.prepared = true;
+    if(mediaSession.aggregatePart) {
+        // media session becomes prepared only after aggregate response is sent
+        mediaSession.observePrepared(owner->sessionLogId, session);
+
+        if(localPeer.sdp().empty()) {
+            aggregatePartDone(mediaSession, StatusCode::BAD_GATEWAY);
+            mediaSessions.erase(it);
+        } else {
+            aggregatePartDone(mediaSession, StatusCode::OK);
+        }
+
+        sendAggregateResponse(describeRequestCSeq);
+        return;
+    }
+
+    mediaSession.onPrepared(owner->sessionLogId, session);
 
     if(localPeer.sdp().empty())
         owner->disconnect();
@@ -142,6 +245,7 @@ void ServerSession::Private::streamerPrepared(const MediaSessionId& session)
 
         response.body = localPeer.sdp();
 
+        metrics::trace::Span span("sendResponse", owner->sessionLogId, session);
         owner->sendResponse(response);
 
         sendIceCandidates(session, &mediaSession);
@@ -160,7 +264,7 @@ void ServerSession::Private::recorderPrepared(const MediaSessionId& session)
     WebRTCPeer& recorder = *mediaSession.localPeer;
     const CSeq recordRequestCSeq = mediaSession.initialRequestCSeq;
 
-    mediaSession.prepared = true;
+    mediaSession.onPrepared(owner->sessionLogId, session);
 
     if(recorder.sdp().empty())
         owner->disconnect();
@@ -172,6 +276,7 @@ void ServerSession::Private::recorderPrepared(const MediaSessionId& session)
 
         response.body = recorder.sdp();
 
+        metrics::trace::Span span("sendResponse", owner->sessionLogId, session);
         owner->sendResponse(response);
 
         sendIceCandidates(session, &mediaSession);
@@ -194,7 +299,7 @@ void ServerSession::Private::recordToClientStreamerPrepared(const MediaSessionId
 
     WebRTCPeer& localPeer = *mediaSession.localPeer;
 
-    mediaSession.prepared = true;
+    mediaSession.onPrepared(owner->sessionLogId, mediaSessionId);
 
     if(localPeer.sdp().empty()) {
         assert(false);
@@ -218,6 +323,8 @@ void ServerSession::Private::iceCandidate(
     const MediaSessionId& session,
     unsigned mlineIndex, const std::string& candidate)
 {
+    metrics::trace::Instant("iceCandidate", owner->sessionLogId, session);
+
     auto it = mediaSessions.find(session);
     if(mediaSessions.end() == it) {
         owner->disconnect();
@@ -255,6 +362,11 @@ void ServerSession::Private::eos(const MediaSessionId& session)
             *owner->createRequest(Method::TEARDOWN, mediaSession.uri, session);
 
         owner->sendRequest(request);
+    } else if(mediaSession.aggregatePart) {
+        aggregatePartDone(mediaSession, StatusCode::BAD_GATEWAY);
+        mediaSessions.erase(it);
+        sendAggregateResponse(describeRequestCSeq);
+        return;
     } else {
         owner->sendBadGatewayResponse(describeRequestCSeq, session);
     }
@@ -262,6 +374,184 @@ void ServerSession::Private::eos(const MediaSessionId& session)
     mediaSessions.erase(it);
 }
 
+void ServerSession::Private::prepareStreamer(
+    const MediaSessionId& session,
+    MediaSession* mediaSession)
+{
+    mediaSession->localPeer->prepare(
+        owner->webRTCConfig(),
+        std::bind(
+            &ServerSession::Private::streamerPrepared,
+            this,
+            session),
+        std::bind(
+            &ServerSession::Private::iceCandidate,
+            this,
+            session,
+            std::placeholders::_1,
+            std::placeholders::_2),
+        std::bind(
+            &ServerSession::Private::eos,
+            this,
+            session),
+        owner->sessionLogId);
+}
+
+bool ServerSession::Private::aggregateDescribe(std::unique_ptr<Request>&& requestPtr)
+{
+    const Request& request = *requestPtr;
+
+    std::vector<std::string> uris;
+    if(!ParseUriList(request.body, &uris) || uris.empty() || uris.size() > MAX_AGGREGATE_URIS) {
+        owner->log()->error("Invalid aggregate DESCRIBE uri list");
+        owner->sendBadRequestResponse(request.cseq);
+        return true;
+    }
+
+    auto emplacePair = aggregateDescribes.emplace(request.cseq, AggregateDescribe());
+    if(!emplacePair.second)
+        return false;
+
+    AggregateDescribe& aggregate = emplacePair.first->second;
+    aggregate.parts.reserve(uris.size());
+
+    std::vector<MediaSessionId> createdSessions;
+    createdSessions.reserve(uris.size());
+
+    for(const std::string& uri: uris) {
+        MediaDescription& part = aggregate.parts.emplace_back(MediaDescription { uri, 0 });
+
+        // every uri is checked the same way as it would be requested by separate DESCRIBE
+        std::unique_ptr<Request> uriRequestPtr = std::make_unique<Request>(request);
+        uriRequestPtr->uri = uri;
+        uriRequestPtr->headerFields.erase(ContentTypeFieldName);
+        uriRequestPtr->body.clear();
+
+        if(!owner->authorize(uriRequestPtr)) {
+            AuthFailuresCounter().inc();
+            owner->log()->error("DESCRIBE authorize failed for \"{}\"", uri);
+            part.statusCode = StatusCode::UNAUTHORIZED;
+            continue;
+        }
+
+        if(owner->isProxyRequest(*uriRequestPtr) || !owner->playEnabled(uri)) {
+            owner->log()->error("Playback is not supported for \"{}\"", uri);
+            part.statusCode = StatusCode::NOT_FOUND;
+            continue;
+        }
+
+        std::unique_ptr<WebRTCPeer> peerPtr;
+        {
+            metrics::trace::Span span("createPeer", owner->sessionLogId);
+            peerPtr = createPeer(uri);
+        }
+        if(!peerPtr) {
+            owner->log()->error("Failed to create peer for \"{}\"", uri);
+            part.statusCode = StatusCode::SERVICE_UNAVAILABLE;
+            continue;
+        }
+
+        const MediaSessionId session = nextSessionId();
+
+        auto sessionEmplacePair =
+            mediaSessions.emplace(
+                session,
+                std::make_unique<MediaSession>(MediaSession::Type::Describe, uri, request.cseq));
+        if(!sessionEmplacePair.second)
+            return false;
+
+        MediaSession& mediaSession = *(sessionEmplacePair.first->second);
+        mediaSession.localPeer = std::move(peerPtr);
+        mediaSession.aggregatePart = aggregate.parts.size() - 1;
+
+        part.session = session;
+        ++aggregate.pending;
+
+        createdSessions.push_back(session);
+    }
+
+    // all parts have to be counted as pending before any of them can get prepared
+    for(const MediaSessionId& session: createdSessions) {
+        auto it = mediaSessions.find(session);
+        if(it != mediaSessions.end())
+            prepareStreamer(session, it->second.get());
+    }
+
+    sendAggregateResponse(request.cseq);
+
+    return true;
+}
+
+void ServerSession::Private::aggregatePartDone(
+    const MediaSession& mediaSession,
+    unsigned statusCode)
+{
+    auto it = aggregateDescribes.find(mediaSession.initialRequestCSeq);
+    if(it == aggregateDescribes.end())
+        return;
+
+    AggregateDescribe& aggregate = it->second;
+    MediaDescription& part = aggregate.parts[*mediaSession.aggregatePart];
+
+    if(part.statusCode == 0) {
+        assert(aggregate.pending > 0);
+        --aggregate.pending;
+    }
+
+    part.statusCode = statusCode;
+    if(statusCode != StatusCode::OK)
+        part.session.clear();
+}
+
+void ServerSession::Private::sendAggregateResponse(CSeq describeRequestCSeq)
+{
+    auto it = aggregateDescribes.find(describeRequestCSeq);
+    if(it == aggregateDescribes.end() || it->second.pending > 0)
+        return;
+
+    AggregateDescribe aggregate = std::move(it->second);
+    aggregateDescribes.erase(it);
+
+    for(MediaDescription& part: aggregate.parts) {
+        if(part.statusCode != StatusCode::OK)
+            continue;
+
+        auto sessionIt = mediaSessions.find(part.session);
+        if(sessionIt == mediaSessions.end()) {
+            part.statusCode = StatusCode::BAD_GATEWAY;
+            part.session.clear();
+            continue;
+        }
+
+        part.sdp = sessionIt->second->localPeer->sdp();
+    }
+
+    Response response;
+    prepareOkResponse(describeRequestCSeq, &response);
+
+    SetContentType(&response, MediaDescriptionsContentType);
+
+    Serialize(aggregate.parts, &response.body);
+
+    {
+        metrics::trace::Span span("sendResponse", owner->sessionLogId);
+        owner->sendResponse(response);
+    }
+
+    for(const MediaDescription& part: aggregate.parts) {
+        if(part.statusCode != StatusCode::OK)
+            continue;
+
+        auto sessionIt = mediaSessions.find(part.session);
+        if(sessionIt == mediaSessions.end())
+            continue;
+
+        MediaSession& mediaSession = *(sessionIt->second);
+        mediaSession.prepared = true;
+        sendIceCandidates(part.session, &mediaSession);
+    }
+}
+
 
 ServerSession::ServerSession(
     const WebRTCConfigPtr& webRTCConfig,
@@ -272,6 +562,7 @@ ServerSession::ServerSession(
     _p(new Private(this, createPeer)),
     _log(MakeServerSessionLogger(sessionLogId))
 {
+    enableRequestMetrics();
 }
 
 ServerSession::ServerSession(
@@ -284,6 +575,7 @@ ServerSession::ServerSession(
     _p(new Private(this, createPeer, createRecordPeer)),
     _log(MakeServerSessionLogger(sessionLogId))
 {
+    enableRequestMetrics();
 }
 
 ServerSession::~ServerSession()
@@ -302,6 +594,12 @@ const std::optional<std::string>& ServerSession::authCookie() const noexcept
     return _p->authCookie;
 }
 
+void ServerSession::setAuthTokenSigner(
+    const std::shared_ptr<const auth::TokenSigner>& authTokenSigner) noexcept
+{
+    _p->authTokenSigner = authTokenSigner;
+}
+
 std::string ServerSession::nextSessionId()
 {
     return _p->nextSessionId();
@@ -310,7 +608,27 @@ std::string ServerSession::nextSessionId()
 bool ServerSession::handleRequest(
     std::unique_ptr<Request>&& requestPtr) noexcept
 {
-    if(requestPtr->method != Method::RECORD && !authorize(requestPtr)) {
+    if(_p->authTokenSigner) {
+        // client sends token only once, usually with very first request
+        std::pair<Authentication, std::string> authPair = ParseAuthentication(*requestPtr);
+        if(authPair.first == Authentication::Bearer)
+            _p->authToken = std::move(authPair.second);
+    }
+
+    requestReceived(*requestPtr);
+
+    const char* methodName = MethodName(requestPtr->method);
+    metrics::trace::Span span(methodName ? methodName : "UNKNOWN", sessionLogId);
+    if(metrics::trace::Enabled())
+        span.setMediaSession(RequestSession(*requestPtr));
+
+    // aggregate DESCRIBE is authorized per requested uri
+    if(requestPtr->method != Method::RECORD &&
+        !IsAggregateDescribe(*requestPtr) &&
+        !authorize(requestPtr))
+    {
+        AuthFailuresCounter().inc();
+
         log()->error("{} authorize failed for \"{}\"", MethodName(requestPtr->method), requestPtr->uri);
 
         sendUnauthorizedResponse(requestPtr->cseq);
@@ -318,7 +636,7 @@ bool ServerSession::handleRequest(
         return true;
     }
 
-    if(isProxyRequest(*requestPtr)) {
+    if(!IsAggregateDescribe(*requestPtr) && isProxyRequest(*requestPtr)) {
         switch(requestPtr->method) {
         case Method::DESCRIBE:
         case Method::SETUP:
@@ -399,13 +717,20 @@ bool ServerSession::onDescribeRequest(
 {
     const Request& request = *requestPtr.get();
 
+    if(IsAggregateDescribe(request))
+        return _p->aggregateDescribe(std::move(requestPtr));
+
     if(!playEnabled(request.uri)) {
         log()->error("Playback is not supported for \"{}\"", requestPtr->uri);
         sendNotFoundResponse(request.cseq);
         return true;
     }
 
-    std::unique_ptr<WebRTCPeer> peerPtr = _p->createPeer(requestPtr->uri);
+    std::unique_ptr<WebRTCPeer> peerPtr;
+    {
+        metrics::trace::Span span("createPeer", sessionLogId);
+        peerPtr = _p->createPeer(requestPtr->uri);
+    }
     if(!peerPtr) {
         log()->error("Failed to create peer for \"{}\"", requestPtr->uri);
         sendServiceUnavailableResponse(request.cseq);
@@ -424,23 +749,7 @@ bool ServerSession::onDescribeRequest(
     MediaSession& mediaSession = *(emplacePair.first->second);
     mediaSession.localPeer = std::move(peerPtr);
 
-    mediaSession.localPeer->prepare(
-        webRTCConfig(),
-        std::bind(
-            &ServerSession::Private::streamerPrepared,
-            _p.get(),
-            session),
-        std::bind(
-            &ServerSession::Private::iceCandidate,
-            _p.get(),
-            session,
-            std::placeholders::_1,
-            std::placeholders::_2),
-        std::bind(
-            &ServerSession::Private::eos,
-            _p.get(),
-            session),
-        sessionLogId);
+    _p->prepareStreamer(session, &mediaSession);
 
     return true;
 }
@@ -457,7 +766,21 @@ bool ServerSession::subscribeEnabled(const std::string&) noexcept
 
 bool ServerSession::authorize(const std::unique_ptr<Request>& requestPtr) noexcept
 {
-    return requestPtr->method != Method::RECORD;
+    // tokens don't grant RECORD, since web session cookies are issued without uri restrictions.
+    // Subclasses have to authorize RECORD explicitly
+    if(requestPtr->method == Method::RECORD)
+        return false;
+
+    return authTokenAllowsUri(requestPtr->uri);
+}
+
+bool ServerSession::authTokenAllowsUri(const std::string& uri) const noexcept
+{
+    if(!_p->authTokenSigner)
+        return true;
+
+    const std::optional<std::string>& token = _p->authToken ? _p->authToken : _p->authCookie;
+    return token && _p->authTokenSigner->verify(*token, uri);
 }
 
 bool ServerSession::onRecordRequest(
@@ -469,6 +792,8 @@ bool ServerSession::onRecordRequest(
         return false;
 
     if(!authorize(requestPtr)) {
+        AuthFailuresCounter().inc();
+
         log()->error("RECORD authorize failed for \"{}\"", requestPtr->uri);
         return false;
     }
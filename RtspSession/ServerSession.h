@@ -6,6 +6,7 @@
 
 #include "RtStreaming/WebRTCPeer.h"
 #include "RtspSession/Session.h"
+#include "Auth/TokenSigner.h"
 
 namespace rtsp {
 
@@ -31,12 +32,21 @@ public:
 
     bool onConnected(const std::optional<std::string>& authCookie = {}) noexcept;
 
+    // if set, default authorize() accepts only requests with valid signed token
+    // (got from Bearer authorization or auth cookie) allowing requested uri.
+    // RECORD is never authorized by default authorize()
+    void setAuthTokenSigner(const std::shared_ptr<const auth::TokenSigner>&) noexcept;
+
     bool handleRequest(std::unique_ptr<Request>&&) noexcept override;
 
     void startRecordToClient(const std::string& uri, const MediaSessionId&) noexcept;
 
 protected:
     const std::optional<std::string>& authCookie() const noexcept;
+    // true if there is no auth token signer or session token allows uri.
+    // Requests with WildcardUri are allowed for any valid token,
+    // so their responses have to be filtered with it
+    bool authTokenAllowsUri(const std::string& uri) const noexcept;
 
     std::string nextSessionId();
 
@@ -5,6 +5,10 @@
 
 #include <glib.h>
 
+#include "RtspParser/RtspSerialize.h"
+
+#include "Metrics/Metrics.h"
+
 #include "Log.h"
 
 
@@ -16,6 +20,56 @@ std::string GenerateSessionLogId()
     return std::to_string(random());
 }
 
+struct MethodMetrics
+{
+    metrics::Counter* requests;
+    metrics::Histogram* duration;
+};
+
+const MethodMetrics& GetMethodMetrics(rtsp::Method method)
+{
+    static const std::vector<MethodMetrics> allMetrics = [] () {
+        std::vector<MethodMetrics> allMetrics;
+
+        metrics::Registry& registry = metrics::Registry::Default();
+        allMetrics.emplace_back(MethodMetrics { nullptr, nullptr }); // Method::NONE
+        for(unsigned m = 1; m <= static_cast<unsigned>(rtsp::Method::SET_PARAMETER); ++m) {
+            const metrics::Labels labels =
+                { { "method", rtsp::MethodName(static_cast<rtsp::Method>(m)) } };
+            allMetrics.emplace_back(MethodMetrics {
+                &registry.counter(
+                    "webrtsp_requests_total",
+                    "Received RTSP requests",
+                    labels),
+                &registry.histogram(
+                    "webrtsp_request_duration_seconds",
+                    "Time from receiving RTSP request to sending response",
+                    metrics::LatencyBuckets(),
+                    labels),
+            });
+        }
+
+        return allMetrics;
+    } ();
+
+    return allMetrics[static_cast<unsigned>(method)];
+}
+
+metrics::Counter& ResponsesCounter(unsigned statusCode)
+{
+    thread_local std::map<unsigned, metrics::Counter*> counters;
+
+    metrics::Counter*& counter = counters[statusCode];
+    if(!counter) {
+        counter = &metrics::Registry::Default().counter(
+            "webrtsp_responses_total",
+            "Sent RTSP responses",
+            { { "status", std::to_string(statusCode) } });
+    }
+
+    return *counter;
+}
+
 }
 
 namespace rtsp {
@@ -279,6 +333,23 @@ CSeq Session::requestDescribe(const std::string& uri) noexcept
     return request.cseq;
 }
 
+CSeq Session::requestDescribe(const std::vector<std::string>& uris) noexcept
+{
+    assert(!uris.empty());
+    if(uris.empty())
+        return InvalidCSeq;
+
+    Request& request = *createRequest(Method::DESCRIBE, WildcardUri);
+
+    SetContentType(&request, UriListContentType);
+
+    Serialize(uris, &request.body);
+
+    sendRequest(request);
+
+    return request.cseq;
+}
+
 CSeq Session::requestSetup(
     const std::string& uri,
     const std::string& contentType,
@@ -394,8 +465,33 @@ CSeq Session::requestSetParameter(
     return request.cseq;
 }
 
+void Session::requestReceived(const Request& request) noexcept
+{
+    if(!_requestMetricsEnabled || request.method == Method::NONE)
+        return;
+
+    const auto& pair =
+        _receivedRequests.emplace(
+            request.cseq,
+            ReceivedRequest { request.method, std::chrono::steady_clock::now() });
+
+    if(pair.second)
+        GetMethodMetrics(request.method).requests->inc();
+}
+
 void Session::sendResponse(const Response& response) noexcept
 {
+    if(_requestMetricsEnabled) {
+        auto it = _receivedRequests.find(response.cseq);
+        if(it != _receivedRequests.end()) {
+            GetMethodMetrics(it->second.method).duration->observe(
+                std::chrono::steady_clock::now() - it->second.receivedAt);
+            _receivedRequests.erase(it);
+        }
+
+        ResponsesCounter(response.statusCode).inc();
+    }
+
     _sendResponse(&response);
 }
 
@@ -424,6 +520,8 @@ bool Session::handleResponse(std::unique_ptr<Response>&& responsePtr) noexcept
 
 bool Session::handleRequest(std::unique_ptr<Request>&& requestPtr) noexcept
 {
+    requestReceived(*requestPtr);
+
     switch(requestPtr->method) {
     case Method::NONE:
         break;
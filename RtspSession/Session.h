@@ -1,9 +1,11 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <functional>
 #include <map>
 #include <deque>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
@@ -92,6 +94,14 @@ protected:
     void sendRequest(const Request&) noexcept;
     void sendResponse(const Response&) noexcept;
 
+    // enables webrtsp_requests_total, webrtsp_request_duration_seconds and webrtsp_responses_total,
+    // intended for server side sessions only
+    void enableRequestMetrics() noexcept { _requestMetricsEnabled = true; }
+
+    // should be called as soon as request is got,
+    // if it can be answered before Session::handleRequest is reached
+    void requestReceived(const Request&) noexcept;
+
     void disconnect() noexcept;
 
     CSeq requestOptions(const std::string& uri) noexcept;
@@ -101,6 +111,8 @@ protected:
         const std::string& list,
         const std::optional<std::string>& token = {}) noexcept;
     CSeq requestDescribe(const std::string& uri) noexcept;
+    // aggregate DESCRIBE, answered with MediaDescriptions in requested uris order
+    CSeq requestDescribe(const std::vector<std::string>& uris) noexcept;
     CSeq requestSetup(
         const std::string& uri,
         const std::string& contentType,
@@ -188,6 +200,14 @@ private:
     CSeq _nextCSeq = 1;
 
     std::map<CSeq, Request> _sentRequests;
+
+    struct ReceivedRequest
+    {
+        Method method;
+        std::chrono::steady_clock::time_point receivedAt;
+    };
+    bool _requestMetricsEnabled = false;
+    std::map<CSeq, ReceivedRequest> _receivedRequests;
 };
 
 }
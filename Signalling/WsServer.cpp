@@ -11,6 +11,9 @@
 #include "RtspParser/RtspParser.h"
 #include "RtspParser/RtspSerialize.h"
 
+#include "Metrics/Metrics.h"
+#include "Metrics/Trace.h"
+
 #include "Log.h"
 
 
@@ -49,6 +52,39 @@ struct SessionContextData
 
 const auto Log = WsServerLog;
 
+struct ServerMetrics
+{
+    metrics::Counter& connections;
+    metrics::Gauge& activeConnections;
+    metrics::Counter& authFailures;
+    metrics::Histogram& sendQueueDepth;
+};
+
+const ServerMetrics& Metrics()
+{
+    static const ServerMetrics serverMetrics {
+        metrics::Registry::Default().counter(
+            "webrtsp_connections_total",
+            "Accepted signalling connections",
+            { { "transport", "ws" } }),
+        metrics::Registry::Default().gauge(
+            "webrtsp_active_connections",
+            "Open signalling connections",
+            { { "transport", "ws" } }),
+        metrics::Registry::Default().counter(
+            "webrtsp_auth_failures_total",
+            "Rejected authorization attempts",
+            { { "source", "ws" } }),
+        metrics::Registry::Default().histogram(
+            "webrtsp_send_queue_depth",
+            "Messages waiting to be written to connection, observed on every send",
+            { 1, 2, 4, 8, 16, 32, 64, 128, 256 },
+            { { "transport", "ws" } }),
+    };
+
+    return serverMetrics;
+}
+
 void LogClientIp(lws* wsi, const std::unique_ptr<rtsp::ServerSession>& session) {
     char clientIp[INET6_ADDRSTRLEN];
     lws_get_peer_simple(wsi, clientIp, sizeof(clientIp));
@@ -90,7 +126,13 @@ void LogClientIp(lws* wsi, const std::unique_ptr<rtsp::ServerSession>& session)
 
 struct WsServer::Private
 {
-    Private(WsServer*, const Config&, GMainLoop*, const WsServer::CreateSession&);
+    Private(
+        WsServer*,
+        const Config&,
+        GMainLoop*,
+        const WsServer::CreateSession&,
+        const std::shared_ptr<auth::TokenStore>&,
+        const std::shared_ptr<const auth::TokenSigner>&);
 
     bool init(lws_context* context);
     int httpCallback(lws*, lws_callback_reasons, void* user, void* in, size_t len);
@@ -105,6 +147,8 @@ struct WsServer::Private
     Config config;
     GMainLoop* loop;
     CreateSession createSession;
+    const std::shared_ptr<auth::TokenStore> authTokenStore;
+    const std::shared_ptr<const auth::TokenSigner> authTokenSigner;
 
     LwsContextPtr contextPtr;
 };
@@ -113,8 +157,11 @@ WsServer::Private::Private(
     WsServer* owner,
     const Config& config,
     GMainLoop* loop,
-    const WsServer::CreateSession& createSession) :
-    owner(owner), config(config), loop(loop), createSession(createSession)
+    const WsServer::CreateSession& createSession,
+    const std::shared_ptr<auth::TokenStore>& authTokenStore,
+    const std::shared_ptr<const auth::TokenSigner>& authTokenSigner) :
+    owner(owner), config(config), loop(loop), createSession(createSession),
+    authTokenStore(authTokenStore), authTokenSigner(authTokenSigner)
 {
 }
 
@@ -162,6 +209,9 @@ int WsServer::Private::wsCallback(
                     .rtspSession = std::move(session)};
             scd->wsi = wsi;
 
+            Metrics().connections.inc();
+            Metrics().activeConnections.inc();
+
             std::optional<std::string> authCookie;
             char cookieBuf[256];
             size_t cookieSize = sizeof(cookieBuf);
@@ -169,6 +219,15 @@ int WsServer::Private::wsCallback(
                 authCookie = std::string(cookieBuf, cookieSize);
             }
 
+            if(authCookie &&
+                ((authTokenStore && !authTokenStore->isValid(*authCookie)) ||
+                (authTokenSigner && !authTokenSigner->verify(*authCookie))))
+            {
+                scd->data->rtspSession->log()->debug("Ignoring invalid auth cookie");
+                Metrics().authFailures.inc();
+                authCookie.reset();
+            }
+
             if(!scd->data->rtspSession->onConnected(authCookie)) {
                 scd->data->rtspSession->log()->error(
                     "websocket session requested connection close in onConnected handler");
@@ -242,6 +301,8 @@ int WsServer::Private::wsCallback(
         case LWS_CALLBACK_CLOSED: {
             scd->data->rtspSession->log()->debug("connection closed");
 
+            Metrics().activeConnections.dec();
+
             delete scd->data;
             scd->data = nullptr;
 
@@ -332,6 +393,8 @@ bool WsServer::Private::onMessage(
 {
     rtsp::ServerSession *const session = scd->data->rtspSession.get();
 
+    metrics::trace::Span span("WsServer::onMessage", session->sessionLogId);
+
     if(rtsp::IsRequest(message.data(), message.size())) {
         std::unique_ptr<rtsp::Request> requestPtr =
             std::make_unique<rtsp::Request>();
@@ -392,6 +455,8 @@ void WsServer::Private::send(SessionContextData* scd, MessageBuffer* message)
 {
     scd->data->sendMessages.emplace_back(std::move(*message));
 
+    Metrics().sendQueueDepth.observe(static_cast<double>(scd->data->sendMessages.size()));
+
     lws_callback_on_writable(scd->wsi);
 }
 
@@ -465,7 +530,25 @@ WsServer::WsServer(
     const Config& config,
     GMainLoop* loop,
     const CreateSession& createSession) noexcept :
-    _p(std::make_unique<Private>(this, config, loop, createSession))
+    _p(std::make_unique<Private>(this, config, loop, createSession, nullptr, nullptr))
+{
+}
+
+WsServer::WsServer(
+    const Config& config,
+    GMainLoop* loop,
+    const CreateSession& createSession,
+    const std::shared_ptr<auth::TokenStore>& authTokenStore) noexcept :
+    _p(std::make_unique<Private>(this, config, loop, createSession, authTokenStore, nullptr))
+{
+}
+
+WsServer::WsServer(
+    const Config& config,
+    GMainLoop* loop,
+    const CreateSession& createSession,
+    const std::shared_ptr<const auth::TokenSigner>& authTokenSigner) noexcept :
+    _p(std::make_unique<Private>(this, config, loop, createSession, nullptr, authTokenSigner))
 {
 }
 
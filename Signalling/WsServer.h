@@ -8,6 +8,8 @@
 
 #include "Config.h"
 #include "RtspSession/ServerSession.h"
+#include "Auth/TokenStore.h"
+#include "Auth/TokenSigner.h"
 
 
 struct lws_context;
@@ -23,6 +25,18 @@ public:
             const rtsp::Session::SendResponse& sendResponse)> CreateSession;
 
     WsServer(const Config&, GMainLoop*, const CreateSession&) noexcept;
+    // only auth cookies present in authTokenStore are passed to ServerSession::onConnected
+    WsServer(
+        const Config&,
+        GMainLoop*,
+        const CreateSession&,
+        const std::shared_ptr<auth::TokenStore>& authTokenStore) noexcept;
+    // only auth cookies verified by authTokenSigner are passed to ServerSession::onConnected
+    WsServer(
+        const Config&,
+        GMainLoop*,
+        const CreateSession&,
+        const std::shared_ptr<const auth::TokenSigner>& authTokenSigner) noexcept;
     bool init(lws_context* = nullptr) noexcept;
     ~WsServer();
 